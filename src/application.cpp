@@ -1,12 +1,15 @@
 #include "application.hpp"
 
+#include "fragment.hpp"
 #include "glad.hpp"
 #include "timer.hpp"
 
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstdio>
 #include <iostream>
 
 namespace Vis {
@@ -15,6 +18,14 @@ Application::Application(const std::vector<std::string_view> &args) {
   if (handle_args(args)) {
     return;
   }
+  m_width = m_headless_info.width;
+  m_height = m_headless_info.height;
+  m_scene_info = SceneInfo::Default(m_width, m_height);
+  apply_scene_options(m_scene_options, m_scene_info, &m_mesh_stats);
+  if (m_headless) {
+    run_headless();
+    return;
+  }
   p_glfw = std::make_shared<Glfw>();
   p_glfw->window_hint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   p_glfw->window_hint(GLFW_CONTEXT_VERSION_MINOR, 6);
@@ -27,49 +38,32 @@ Application::Application(const std::vector<std::string_view> &args) {
   glDebugMessageCallback(Glad::print_gl_message, nullptr);
   std::cout << "OpenGL: Version " << glGetString(GL_VERSION) << '\n';
   p_texture = std::make_unique<Texture>();
-  p_texture->bind();
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   p_gui = std::make_unique<Gui>(*p_window, "#version 460");
   ImGuiIO &io = ImGui::GetIO();
   io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
   io.ConfigDockingWithShift = true;
   ImGui::StyleColorsDark();
-  m_scene_info.simulated_camera = std::make_unique<Camera>();
-  m_scene_info.simulated_camera->width = static_cast<double>(m_width);
-  m_scene_info.simulated_camera->height = static_cast<double>(m_height);
-  m_scene_info.simulated_camera->position = {-2.0, 0.0, 0.0};
-  m_scene_info.simulated_camera->near_plane = 1.0;
-  m_scene_info.simulated_camera->far_plane = 10.0;
-  m_scene_info.render_camera = std::make_unique<Camera>();
-  m_scene_info.render_camera->width = static_cast<double>(m_width);
-  m_scene_info.render_camera->height = static_cast<double>(m_height);
-  m_scene_info.render_camera->position = {-1.0, 0.0, 0.0};
-  m_scene_info.render_camera->near_plane = 0.1;
-  m_scene_info.render_camera->far_plane = 100.0;
-  m_scene_info.active_camera = m_scene_info.simulated_camera.get();
-  m_scene_info.simulated_solid.matrix = glm::translate(glm::dmat4{1.0}, {3.0, 0.0, 0.0});
   run();
 }
 
 [[nodiscard]] auto Application::handle_args(const std::vector<std::string_view> &args) -> bool {
-  [[maybe_unused]] size_t i = 0;
-  for (const auto &arg : args) {
+  for (size_t i = 1; i < args.size(); ++i) {
+    const auto &arg = args[i];
+    const auto next = [&]() -> std::string_view {
+      if (i + 1 >= args.size() || args[i + 1][0] == '-') {
+        throw std::runtime_error("Missing argument for " + std::string{arg});
+      }
+      return args[++i];
+    };
     if (arg == "-h" || arg == "--help") {
       return arg_print_help();
-    }
-    if (arg == "-v" || arg == "--version") {
+    } else if (arg == "-v" || arg == "--version") {
       return arg_print_version();
+    } else if (arg == "--headless") {
+      m_headless = true;
+    } else if (!parse_render_option(arg, next, m_headless_info, m_scene_options)) {
+      throw std::runtime_error("Unknown argument " + std::string{arg});
     }
-    if (arg == "-r" || arg == "--res") {
-      if (i + 1 >= args.size() || args[i + 1][0] == '-') {
-        throw std::runtime_error("Missing resolution argument");
-      }
-      arg_resolution(args[i + 1]);
-    }
-    ++i;
   }
   return false;
 }
@@ -78,7 +72,8 @@ auto Application::arg_print_help() -> bool {
   std::cout << "VIS HELP:\n";
   std::cout << " --help, -h: print help\n";
   std::cout << " --version, -v: print version\n";
-  std::cout << " --res, -r: sets resolution (default 800x600)\n";
+  std::cout << " --headless: renders without a window, GL context or GUI\n";
+  print_render_options_help(std::cout);
   return true;
 }
 
@@ -87,206 +82,83 @@ auto Application::arg_print_version() -> bool {
   return true;
 }
 
-auto Application::arg_resolution(const std::string_view resolution) -> void {
-  auto x = resolution.find('x');
-  if (x == std::string::npos) {
-    throw std::runtime_error("Resolution argument is in wrong format!");
-  }
-
-  const auto width = resolution.substr(0, x);
-  const auto height = resolution.substr(x + 1, resolution.size());
-  if (width.empty() || height.empty()) {
-    throw std::runtime_error("Resolution argument is in wrong format!");
-  }
-
-  if (!std::isdigit(width[0]) || !std::isdigit(height[0])) {
-    throw std::runtime_error("Resolution argument is in wrong format!");
-  }
-
-  std::stringstream ss;
-  ss << width;
-  ss >> m_width;
-
-  ss.clear();
-  ss.str("");
-
-  ss << height;
-  ss >> m_height;
-}
-
 auto Application::run() -> void {
+  m_renderer.set_profiler(&m_profiler);
   while (!p_window->should_close()) {
+    m_profiler.begin_frame();
+    Profiler::Scope frame_scope{&m_profiler, "frame"};
     Timer timer(&m_last_loop_time);
 
-    handle_input();
-    make_gui();
-    render_image();
-
-    p_gui->render();
-    p_window->swap_buffers();
-  }
-}
-
-auto Application::render(std::vector<Vertex> &vertices, const Pipeline &pipeline, const glm::dmat4 &matrix) -> void {
-  pipeline.trasform_vertices(vertices, matrix);
-  pipeline.clip_fast(vertices);
-  pipeline.clip_before_dehomog(vertices);
-  pipeline.dehomog(vertices);
-  pipeline.clip_after_dehomog(vertices);
-  pipeline.trasform_to_viewport(vertices, m_image);
-  pipeline.rasterize(vertices, m_image, pipeline.set_pixel);
-}
+    {
+      Profiler::Scope scope{&m_profiler, "handle_input"};
+      handle_input();
+    }
+    {
+      Profiler::Scope scope{&m_profiler, "make_gui"};
+      make_gui();
+    }
+    {
+      Profiler::Scope scope{&m_profiler, "render_image"};
+      render_image();
+    }
 
-template <size_t vertices_per_primitie, AddToNewSolid add_to_new_solid> auto Application::render_topology(const Layout &layout, const Solid &solid, const Pipeline &pipeline, const glm::dmat4 &matrix, Solid *new_solid) -> void {
-  std::vector<Vertex> primitive;
-  primitive.reserve(vertices_per_primitie);
-  for (size_t i = layout.start; i < layout.start + layout.count * vertices_per_primitie; i += vertices_per_primitie) {
-    primitive.clear();
-    for (size_t j = 0; j < vertices_per_primitie; ++j) {
-      primitive.push_back(solid.vertices[solid.indices[i + j]]);
-    }
-    render(primitive, pipeline, matrix);
-    if constexpr (add_to_new_solid == AddToNewSolid::True) {
-      const size_t new_size = new_solid->vertices.size() + primitive.size();
-      new_solid->vertices.reserve(new_size);
-      new_solid->indices.reserve(new_size);
-      if (primitive.size() % vertices_per_primitie == 0) {
-        if (new_solid->layout.size() > 0 && new_solid->layout.back().topology == layout.topology) {
-          for (size_t j = 0; j < primitive.size(); j += vertices_per_primitie) {
-            for (size_t k = 0; k < vertices_per_primitie; ++k) {
-              new_solid->vertices.push_back(primitive[j + k]);
-              new_solid->indices.push_back(new_solid->indices.size());
-            }
-            ++new_solid->layout.back().count;
-          }
-        } else {
-          new_solid->layout.push_back({layout.topology, new_solid->vertices.size(), 0});
-          for (size_t j = 0; j < primitive.size(); j += vertices_per_primitie) {
-            for (size_t k = 0; k < vertices_per_primitie; ++k) {
-              new_solid->vertices.push_back(primitive[j + k]);
-              new_solid->indices.push_back(new_solid->indices.size());
-            }
-            ++new_solid->layout.back().count;
-          }
-        }
-      }
+    {
+      Profiler::Scope scope{&m_profiler, "present"};
+      p_gui->render();
+      p_window->swap_buffers();
     }
   }
 }
 
-auto Application::simulate_solid(const Solid &solid) -> Solid {
-  auto matrix = m_scene_info.simulated_camera->get_projection() * m_scene_info.simulated_camera->get_view() * m_scene_info.simulated_model_matrix * solid.matrix;
-  Solid new_solid;
-  new_solid.name = solid.name;
-  new_solid.matrix = glm::dmat4{1.0};
-  for (const auto layout : solid.layout) {
-    switch (layout.topology) {
-    case Topology::Point: {
-      render_topology<1, AddToNewSolid::True>(layout, solid, m_scene_info.simulate_point_pipeline, matrix, &new_solid);
-    } break;
-    case Topology::Line: {
-      render_topology<2, AddToNewSolid::True>(layout, solid, m_scene_info.simulate_line_pipeline, matrix, &new_solid);
-    } break;
-    case Topology::Triangle: {
-      render_topology<3, AddToNewSolid::True>(layout, solid, m_scene_info.simulate_triangle_pipeline, matrix, &new_solid);
-    } break;
-    }
-  }
-  return new_solid;
-}
-
-auto get_camera_model(const Camera &camera) -> Solid {
-  Solid solid{};
-  solid.name = "";
-  solid.matrix = glm::dmat4{1.0};
-  solid.vertices.reserve(9);
-  glm::dvec4 color = {1.0, 1.0, 1.0, 1.0};
-  Vertex v1{};
-  v1.pos = {camera.position.x, camera.position.y, camera.position.z, 1.0};
-  v1.col = color;
-  solid.vertices.push_back(v1);
-  std::array<Vertex, 8> vertices{};
-  vertices[0].pos = {-1.0, -1.0, 0.0, 1.0};
-  vertices[1].pos = {1.0, -1.0, 0.0, 1.0};
-  vertices[2].pos = {-1.0, 1.0, 0.0, 1.0};
-  vertices[3].pos = {1.0, 1.0, 0.0, 1.0};
-  vertices[4].pos = {-1.0, -1.0, 1.0, 1.0};
-  vertices[5].pos = {1.0, -1.0, 1.0, 1.0};
-  vertices[6].pos = {-1.0, 1.0, 1.0, 1.0};
-  vertices[7].pos = {1.0, 1.0, 1.0, 1.0};
-  for (size_t i = 0; i < vertices.size(); ++i) {
-    vertices[i].col = color;
-    vertices[i].pos = glm::inverse(camera.get_view()) * glm::inverse(camera.get_projection()) * vertices[i].pos;
-    solid.vertices.push_back(vertices[i]);
-  }
-  solid.indices = {0, 5, 0, 6, 0, 7, 0, 8, 1, 2, 2, 4, 4, 3, 3, 1, 5, 6, 6, 8, 8, 7, 7, 5};
-  solid.layout.push_back({Topology::Line, 0, 12});
-  return solid;
-};
-
-auto Application::render_solid(const Solid &solid) -> void {
-  auto matrix = m_scene_info.active_camera->get_projection() * m_scene_info.active_camera->get_view() * m_scene_info.model_matrix * solid.matrix;
-  for (const auto layout : solid.layout) {
-    switch (layout.topology) {
-    case Topology::Point: {
-      render_topology<1, AddToNewSolid::False>(layout, solid, m_scene_info.render_point_pipeline, matrix);
-    } break;
-    case Topology::Line: {
-      render_topology<2, AddToNewSolid::False>(layout, solid, m_scene_info.render_line_pipeline, matrix);
-    } break;
-    case Topology::Triangle: {
-      render_topology<3, AddToNewSolid::False>(layout, solid, m_scene_info.render_triangle_pipeline, matrix);
-    } break;
-    }
+auto Application::run_headless() -> void {
+  const auto total_time = m_renderer.render_frames(m_scene_info, m_headless_info);
+  std::cout << "Rendered " << m_headless_info.frames << " frames at " << m_headless_info.width << 'x' << m_headless_info.height << " in " << total_time << " s (" << total_time * 1000.0 / static_cast<double>(m_headless_info.frames) << " ms/frame)\n";
+  if (m_headless_info.stats) {
+    std::cout << m_renderer.get_stats();
   }
 }
 
 auto Application::render_image() -> void {
-  if (m_panel_width != m_image.get_width() || m_panel_height != m_image.get_height()) {
-    m_image.resize(static_cast<size_t>(m_panel_width), static_cast<size_t>(m_panel_height));
-    m_scene_info.active_camera->width = m_panel_width;
-    m_scene_info.active_camera->height = m_panel_height;
+  const auto width = static_cast<size_t>(m_panel_width);
+  const auto height = static_cast<size_t>(m_panel_height);
+  auto &image = m_renderer.get_image();
+  if (width == 0 || height == 0) {
+    image.set_color_target(nullptr);
+    p_pixel_buffers.reset();
+    m_renderer.render_image(m_scene_info, width, height);
+    if (!m_headless_info.dump_path.empty()) {
+      image.save(m_headless_info.dump_path);
+      m_headless_info.dump_path.clear();
+    }
+    return;
   }
-  m_image.clear({0.05, 0.05, 0.05, 1.0});
-  if (m_scene_info.simulate) {
-    Solid simulated = simulate_solid(m_scene_info.simulated_solid);
-    glm::dmat4 scene_matrix = {1.0};
-    Solid camera_solid = get_camera_model(*m_scene_info.simulated_camera.get());
-    switch (m_scene_info.scene_space) {
-    case SceneSpace::SolidModel: {
-      simulated.matrix = glm::dmat4{glm::inverse(m_scene_info.simulated_solid.matrix) * glm::inverse(m_scene_info.simulated_camera->get_view()) * glm::inverse(m_scene_info.simulated_camera->get_projection())};
-    } break;
-    case SceneSpace::SceneModel: {
-      simulated.matrix = glm::dmat4{glm::inverse(m_scene_info.simulated_camera->get_view()) * glm::inverse(m_scene_info.simulated_camera->get_projection())};
-    } break;
-    case SceneSpace::View: {
-      simulated.matrix = glm::dmat4{glm::inverse(m_scene_info.simulated_camera->get_projection())};
-      scene_matrix = {0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
-      camera_solid.matrix = m_scene_info.simulated_camera->get_view();
-    } break;
-    case SceneSpace::Projection: {
-      scene_matrix = {0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
-      camera_solid.indices[0] = 1;
-      camera_solid.indices[2] = 2;
-      camera_solid.indices[4] = 3;
-      camera_solid.indices[6] = 4;
-      camera_solid.matrix = m_scene_info.simulated_camera->get_projection() * m_scene_info.simulated_camera->get_view();
-    } break;
-    }
-    std::swap(scene_matrix, m_scene_info.model_matrix);
-    render_solid(simulated);
-    if (m_scene_info.scene_space != SceneSpace::SolidModel) {
-      render_solid(camera_solid);
-    }
-    if (m_scene_info.render_axis) {
-      render_solid(Solid::Axis());
-    }
-    std::swap(scene_matrix, m_scene_info.model_matrix);
-  } else {
-    render_solid(m_scene_info.simulated_solid);
+  if (!p_pixel_buffers || p_pixel_buffers->get_width() != width || p_pixel_buffers->get_height() != height) {
+    Profiler::Scope scope{&m_profiler, "reallocate"};
+    image.set_color_target(nullptr);
+    p_pixel_buffers.reset();
+    p_texture = std::make_unique<Texture>();
+    p_texture->storage(width, height);
+    p_pixel_buffers = std::make_unique<PixelBufferRing>(width, height);
   }
+  ColorRGBA8 *pixels{nullptr};
+  {
+    Profiler::Scope scope{&m_profiler, "acquire"};
+    pixels = p_pixel_buffers->acquire();
+  }
+  // The pixel buffers are mapped write only, so a frame that is dumped renders
+  // into the image's own buffer and is copied over afterwards.
+  const auto dump = !m_headless_info.dump_path.empty();
+  image.set_color_target(dump ? nullptr : pixels);
+  m_renderer.render_image(m_scene_info, width, height);
+  if (dump) {
+    image.save(m_headless_info.dump_path);
+    m_headless_info.dump_path.clear();
+    image.resolve();
+    std::copy_n(image.get_image_data(), width * height, pixels);
+  }
+  Profiler::Scope scope{&m_profiler, "upload"};
   p_texture->bind();
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(m_panel_width), static_cast<GLsizei>(m_panel_height), 0, GL_RGBA, GL_UNSIGNED_BYTE, m_image.get_image_data());
+  p_pixel_buffers->upload();
 }
 
 auto Application::handle_input() -> void {
@@ -430,10 +302,34 @@ auto Application::make_gui(bool show_debug) -> void {
   ImGui::Text("m_mouse_pos_x: %f", m_mouse_pos_x);
   ImGui::Text("m_mouse_pos_y: %f", m_mouse_pos_y);
   ImGui::Text("m_image:");
-  ImGui::Text("- width: %zu", m_image.get_width());
-  ImGui::Text("- height: %zu", m_image.get_height());
+  ImGui::Text("- width: %zu", m_renderer.get_image().get_width());
+  ImGui::Text("- height: %zu", m_renderer.get_image().get_height());
+  ImGui::Text("- precision: %s", sizeof(Real) == sizeof(float) ? "float" : "double");
+  ImGui::Text("- vertex size: %zu B", sizeof(Vertex));
   ImGui::Text("m_last_loop_time: %f", m_last_loop_time);
   ImGui::Text("- fps: %f", 1 / m_last_loop_time);
+  ImGui::SeparatorText("Profiler");
+  ImGui::Text("frames: %zu, times in ms (mean, p50, p95, p99)", m_profiler.get_frame_count());
+  {
+    const auto &sections = m_profiler.get_sections();
+    const auto frame_time = sections.empty() ? 0.0 : m_profiler.get_mean(sections.front());
+    const auto make_bars = [&](const auto &self, const size_t parent) -> void {
+      for (size_t i = 0; i < sections.size(); ++i) {
+        const auto &section = sections[i];
+        if (section.parent != parent) {
+          continue;
+        }
+        const auto mean = m_profiler.get_mean(section);
+        std::array<char, 160> label{};
+        std::snprintf(label.data(), label.size(), "%s %.3f, %.3f, %.3f, %.3f", section.name.c_str(), mean * 1000.0, m_profiler.get_percentile(section, 0.5) * 1000.0, m_profiler.get_percentile(section, 0.95) * 1000.0, m_profiler.get_percentile(section, 0.99) * 1000.0);
+        ImGui::Indent(static_cast<float>(section.depth) * 8.0f);
+        ImGui::ProgressBar(frame_time > 0.0 ? static_cast<float>(mean / frame_time) : 0.0f, ImVec2{-1.0f, 0.0f}, label.data());
+        ImGui::Unindent(static_cast<float>(section.depth) * 8.0f);
+        self(self, i);
+      }
+    };
+    make_bars(make_bars, Profiler::no_parent);
+  }
   ImGui::End();
 
   ImGui::Begin("Settings");
@@ -456,11 +352,21 @@ auto Application::make_gui(bool show_debug) -> void {
   }
   {
 
-    enum class Solids { Triangle, Square, Cube, IcoSphere };
-    constexpr std::array<const char *, 4> solids_text = {"triangle", "square", "cube", "icosphere"};
-    static int solids{static_cast<int>(Solids::Cube)};
-    auto change = ImGui::Combo("Solids##1", &solids, solids_text.data(), static_cast<int>(solids_text.size()));
+    enum class Solids { Triangle, Square, Cube, IcoSphere, GeneratedIcoSphere, Grid, Torus, CubeSphere, Mesh };
+    constexpr std::array<const char *, 9> solids_text = {"triangle", "square", "cube", "icosphere", "icosphere level", "grid", "torus", "cube sphere", "mesh"};
+    static int solids{static_cast<int>(m_scene_options.mesh_path.empty() ? Solids::Cube : Solids::Mesh)};
+    // Subdivisions of the generated icosphere, cells or sides of the others.
+    static int level{4};
+    const auto solids_count = m_scene_options.mesh_path.empty() ? solids_text.size() - 1 : solids_text.size();
+    auto change = ImGui::Combo("Solids##1", &solids, solids_text.data(), static_cast<int>(solids_count));
+    const auto generated = static_cast<Solids>(solids) >= Solids::GeneratedIcoSphere && static_cast<Solids>(solids) <= Solids::CubeSphere;
+    if (generated) {
+      const auto max_level = static_cast<Solids>(solids) == Solids::GeneratedIcoSphere ? 9 : 1024;
+      change |= ImGui::SliderInt("Level##1", &level, 1, max_level);
+      level = std::clamp(level, 1, max_level);
+    }
     if (change) {
+      const auto resolution = static_cast<size_t>(level);
       switch (static_cast<Solids>(solids)) {
       case Solids::Triangle: {
         m_scene_info.simulated_solid = Solid::Triangle();
@@ -474,6 +380,32 @@ auto Application::make_gui(bool show_debug) -> void {
       case Solids::IcoSphere: {
         m_scene_info.simulated_solid = Solid::Icosphere();
       } break;
+      case Solids::GeneratedIcoSphere: {
+        m_scene_info.simulated_solid = Solid::Icosphere(resolution);
+      } break;
+      case Solids::Grid: {
+        m_scene_info.simulated_solid = Solid::Grid(resolution, resolution);
+      } break;
+      case Solids::Torus: {
+        m_scene_info.simulated_solid = Solid::Torus(std::max<size_t>(resolution, 3) * 2, std::max<size_t>(resolution, 3));
+      } break;
+      case Solids::CubeSphere: {
+        m_scene_info.simulated_solid = Solid::CubeSphere(resolution);
+      } break;
+      case Solids::Mesh: {
+        load_simulated_mesh(m_scene_options.mesh_path, m_scene_info, &m_mesh_stats);
+      } break;
+      }
+    }
+    if (generated) {
+      ImGui::Text("%zu vertices, %zu triangles", m_scene_info.simulated_solid.get_vertices().size(), m_scene_info.simulated_solid.indices.size() / 3);
+    }
+    if (static_cast<Solids>(solids) == Solids::Mesh) {
+      ImGui::Text("%zu vertices, %zu triangles", m_mesh_stats.vertices, m_mesh_stats.triangles);
+      if (m_mesh_stats.bytes == 0) {
+        ImGui::Text("Loaded in %.3f s", m_mesh_stats.seconds);
+      } else {
+        ImGui::Text("Loaded in %.3f s (%.1f MB/s)", m_mesh_stats.seconds, m_mesh_stats.megabytes_per_second());
       }
     }
   }
@@ -488,6 +420,28 @@ auto Application::make_gui(bool show_debug) -> void {
     }
   }
   if (ImGui::CollapsingHeader("Render triangle pipeline")) {
+    {
+      enum class FetchVertices { FETCH_VERTICES_BY_MATRIX, FETCH_VERTICES_INDEXED, FETCH_TRIANGLES_BY_STREAM };
+      constexpr std::array<const char *, 3> fetch_vertices_text = {"fetch_vertices_by_matrix", "fetch_vertices_indexed", "fetch_triangles_by_stream"};
+      static int fetch_vertices{static_cast<int>(FetchVertices::FETCH_VERTICES_BY_MATRIX)};
+      auto change = ImGui::Combo("Fetch vertices##1", &fetch_vertices, fetch_vertices_text.data(), static_cast<int>(fetch_vertices_text.size()));
+      if (change) {
+        switch (static_cast<FetchVertices>(fetch_vertices)) {
+        case FetchVertices::FETCH_VERTICES_BY_MATRIX: {
+          m_scene_info.render_triangle_pipeline.fetch_vertices = Alg::fetch_vertices_by_matrix;
+          m_scene_info.render_triangle_pipeline.trasform_vertices = Alg::trasform_vertices_by_none;
+        } break;
+        case FetchVertices::FETCH_VERTICES_INDEXED: {
+          m_scene_info.render_triangle_pipeline.fetch_vertices = Alg::fetch_vertices_indexed;
+          m_scene_info.render_triangle_pipeline.trasform_vertices = Alg::trasform_vertices_by_matrix;
+        } break;
+        case FetchVertices::FETCH_TRIANGLES_BY_STREAM: {
+          m_scene_info.render_triangle_pipeline.fetch_vertices = Alg::fetch_triangles_by_stream;
+          m_scene_info.render_triangle_pipeline.trasform_vertices = Alg::trasform_vertices_by_none;
+        } break;
+        }
+      }
+    }
     {
       enum class ClipFast { CLIP_FAST_TRIANGLE, CLIP_FAST_NONE };
       constexpr std::array<const char *, 2> clip_fast_text = {"clip_fast_triangle", "clip_fast_none"};
@@ -537,8 +491,8 @@ auto Application::make_gui(bool show_debug) -> void {
       }
     }
     {
-      enum class ClipAfterDehomog { CLIP_AFTER_DEHOMOG_TRIANGLE, CLIP_AFTER_DEHOMOG_NONE };
-      constexpr std::array<const char *, 2> clip_after_dehomog_text = {"clip_after_dehomog_triangle", "clip_after_dehomog_none"};
+      enum class ClipAfterDehomog { CLIP_AFTER_DEHOMOG_TRIANGLE, CLIP_AFTER_DEHOMOG_NONE, CLIP_AFTER_DEHOMOG_GUARD_BAND };
+      constexpr std::array<const char *, 3> clip_after_dehomog_text = {"clip_after_dehomog_triangle", "clip_after_dehomog_none", "clip_after_dehomog_guard_band"};
       static int clip_after_demohog{static_cast<int>(ClipAfterDehomog::CLIP_AFTER_DEHOMOG_TRIANGLE)};
       auto change = ImGui::Combo("Clip after dehomog##1", &clip_after_demohog, clip_after_dehomog_text.data(), static_cast<int>(clip_after_dehomog_text.size()));
       if (change) {
@@ -549,12 +503,15 @@ auto Application::make_gui(bool show_debug) -> void {
         case ClipAfterDehomog::CLIP_AFTER_DEHOMOG_NONE: {
           m_scene_info.render_triangle_pipeline.clip_after_dehomog = Alg::clip_after_dehomog_none;
         } break;
+        case ClipAfterDehomog::CLIP_AFTER_DEHOMOG_GUARD_BAND: {
+          m_scene_info.render_triangle_pipeline.clip_after_dehomog = Alg::clip_after_dehomog_guard_band;
+        } break;
         }
       }
     }
     {
-      enum class RasterizeTriangle { RasterizeNone, RasterizeTriangle, RasterizeTriangleAsLines };
-      constexpr std::array<const char *, 3> rasterize_triangle_text = {"rasterize_none", "rasterize_triangle", "rasterize_triangle_as_lines"};
+      enum class RasterizeTriangle { RasterizeNone, RasterizeTriangle, RasterizeTriangleAsLines, RasterizeTriangleTiled, RasterizeTriangleEdge, RasterizeTriangleQuad, RasterizeTriangleEarlyZ };
+      constexpr std::array<const char *, 7> rasterize_triangle_text = {"rasterize_none", "rasterize_triangle", "rasterize_triangle_as_lines", "rasterize_triangle_tiled", "rasterize_triangle_edge", "rasterize_triangle_quad", "rasterize_triangle_early_z"};
       static int rasterize_triangle{static_cast<int>(RasterizeTriangle::RasterizeTriangle)};
       auto change = ImGui::Combo("Rasterize triangle##1", &rasterize_triangle, rasterize_triangle_text.data(), static_cast<int>(rasterize_triangle_text.size()));
       if (change) {
@@ -568,6 +525,18 @@ auto Application::make_gui(bool show_debug) -> void {
         case RasterizeTriangle::RasterizeTriangleAsLines: {
           m_scene_info.render_triangle_pipeline.rasterize = Alg::rasterize_triangle_as_lines;
         } break;
+        case RasterizeTriangle::RasterizeTriangleTiled: {
+          m_scene_info.render_triangle_pipeline.rasterize = Alg::rasterize_triangle_tiled;
+        } break;
+        case RasterizeTriangle::RasterizeTriangleEdge: {
+          m_scene_info.render_triangle_pipeline.rasterize = Alg::rasterize_triangle_edge;
+        } break;
+        case RasterizeTriangle::RasterizeTriangleQuad: {
+          m_scene_info.render_triangle_pipeline.rasterize = Alg::rasterize_triangle_quad;
+        } break;
+        case RasterizeTriangle::RasterizeTriangleEarlyZ: {
+          m_scene_info.render_triangle_pipeline.rasterize = Alg::rasterize_triangle_early_z;
+        } break;
         }
       }
     }
@@ -600,6 +569,78 @@ auto Application::make_gui(bool show_debug) -> void {
       }
     }
   }
+  if (ImGui::CollapsingHeader("Quad shading")) {
+    constexpr std::array<const char *, 3> simd_level_text = {"scalar", "sse2", "avx2"};
+    int simd_level{static_cast<int>(Alg::get_simd_level())};
+    if (ImGui::Combo("SIMD##1", &simd_level, simd_level_text.data(), static_cast<int>(simd_level_text.size()))) {
+      Alg::set_simd_level(static_cast<SimdLevel>(simd_level));
+    }
+    ImGui::Text("detected: %s", simd_level_text[static_cast<size_t>(Alg::detect_simd_level())]);
+  }
+  if (ImGui::CollapsingHeader("Pipeline statistics")) {
+    bool enabled{m_renderer.get_stats_enabled()};
+    if (ImGui::Checkbox("Enabled##1", &enabled)) {
+      m_renderer.set_stats_enabled(enabled);
+    }
+    const auto &stats = m_renderer.get_stats();
+    ImGui::Text("vertices: %zu", stats.vertices);
+    ImGui::Text("primitives: %zu", stats.primitives);
+    ImGui::Text("clip_fast: %zu -> %zu", stats.clip_fast.in, stats.clip_fast.out);
+    ImGui::Text("clip_before_dehomog: %zu -> %zu", stats.clip_before_dehomog.in, stats.clip_before_dehomog.out);
+    ImGui::Text("clip_after_dehomog: %zu -> %zu", stats.clip_after_dehomog.in, stats.clip_after_dehomog.out);
+    ImGui::Text("fragments: %zu", stats.fragment.fragments);
+    ImGui::Text("depth passed: %zu", stats.fragment.depth_passed);
+    ImGui::Text("depth failed: %zu", stats.fragment.depth_failed);
+    ImGui::Text("discarded: %zu", stats.fragment.discarded);
+    ImGui::Text("pixels covered: %zu", stats.fragment.pixels_covered);
+    ImGui::Text("overdraw: %.2f", stats.overdraw());
+  }
+  if (ImGui::CollapsingHeader("Guard band")) {
+    float guard_band{static_cast<float>(m_renderer.get_guard_band())};
+    if (ImGui::SliderFloat("Size##1", &guard_band, 1.0f, 64.0f)) {
+      m_renderer.set_guard_band(static_cast<Real>(guard_band));
+    }
+    const auto &stats = m_renderer.get_guard_band_stats();
+    ImGui::Text("inside: %zu", stats.inside);
+    ImGui::Text("guard band: %zu", stats.guard_band);
+    ImGui::Text("clipped: %zu", stats.clipped);
+    ImGui::Text("culled: %zu", stats.culled);
+  }
+  if (ImGui::CollapsingHeader("Depth buffer")) {
+    enum class DepthFormatItem { NATIVE, D16, D24, D32F };
+    constexpr std::array<const char *, 4> depth_format_text = {"native", "d16", "d24", "d32f"};
+    static int depth_format{static_cast<int>(DepthFormatItem::NATIVE)};
+    auto change = ImGui::Combo("Format##1", &depth_format, depth_format_text.data(), static_cast<int>(depth_format_text.size()));
+    if (change) {
+      switch (static_cast<DepthFormatItem>(depth_format)) {
+      case DepthFormatItem::NATIVE: {
+        m_renderer.get_image().set_depth_format(DepthFormat::Native);
+      } break;
+      case DepthFormatItem::D16: {
+        m_renderer.get_image().set_depth_format(DepthFormat::D16);
+      } break;
+      case DepthFormatItem::D24: {
+        m_renderer.get_image().set_depth_format(DepthFormat::D24);
+      } break;
+      case DepthFormatItem::D32F: {
+        m_renderer.get_image().set_depth_format(DepthFormat::D32F);
+      } break;
+      }
+    }
+    ImGui::Text("size: %.2f MB", static_cast<double>(m_renderer.get_image().get_depth_buffer_size()) / (1024.0 * 1024.0));
+  }
+  if (ImGui::CollapsingHeader("Hierarchical Z")) {
+    auto &image = m_renderer.get_image();
+    bool enabled{image.get_hiz_enabled()};
+    if (ImGui::Checkbox("Enabled##2", &enabled)) {
+      image.set_hiz_enabled(enabled);
+    }
+    const auto stats = image.get_hiz_stats();
+    ImGui::Text("triangles tested: %zu", stats.triangles_tested);
+    ImGui::Text("triangles rejected: %zu", stats.triangles_rejected);
+    ImGui::Text("spans rejected: %zu", stats.spans_rejected);
+    ImGui::Text("pixels rejected: %zu", stats.pixels_rejected);
+  }
   if (ImGui::CollapsingHeader("Render line pipeline")) {
     {
       enum class ClipFast { CLIP_FAST_LINE, CLIP_FAST_NONE };
@@ -0,0 +1,405 @@
+// Times every Alg:: stage over synthetic workloads and reports ns/vertex,
+// ns/pixel and throughput, optionally as JSON for tracking across commits.
+#include "main.hpp"
+#include "pipeline.hpp"
+#include "solid.hpp"
+#include "timer.hpp"
+
+#include <glm/ext.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Vis::Image;
+using Vis::Real;
+using Vis::Vec4;
+using Vis::Vertex;
+
+struct Options {
+  size_t width{1280};
+  size_t height{720};
+  size_t iterations{10};
+  // Workloads whose rasterized area exceeds this many pixels are skipped, so
+  // large triangle counts are only combined with small triangles.
+  double pixel_budget{16'000'000.0};
+  std::string filter{};
+  std::string json_path{};
+  // Solid::Generate descriptions, replacing the random workloads when set.
+  std::vector<std::string> generated{};
+};
+
+struct Workload {
+  size_t triangles{0};
+  double size{0.0};
+  double clip_ratio{0.0};
+  std::vector<Vertex> vertices{};
+  std::vector<size_t> indices{};
+  // The same indices as a Solid with more than 65536 vertices stores them.
+  std::vector<uint32_t> indices_32{};
+  std::string label{};
+
+  [[nodiscard]] auto name() const -> std::string {
+    if (!label.empty()) {
+      return label;
+    }
+    std::stringstream ss;
+    ss << "tri" << triangles << "_size" << size << "_clip" << static_cast<int>(clip_ratio * 100.0);
+    return ss.str();
+  }
+};
+
+struct Result {
+  std::string workload{};
+  std::string stage{};
+  size_t vertices{0};
+  size_t pixels{0};
+  double median_ns{0.0};
+  double min_ns{0.0};
+};
+
+// Builds `triangles` clip-space triangles of roughly `size` pixels on a side.
+// A `clip_ratio` share of them straddles a viewport edge or the near plane.
+auto make_workload(const Options &options, const size_t triangles, const double size, const double clip_ratio) -> Workload {
+  Workload workload{triangles, size, clip_ratio};
+  std::mt19937 rng(static_cast<std::mt19937::result_type>(triangles * 7919 + static_cast<size_t>(size * 31.0 + clip_ratio * 100.0)));
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  const double extent_x = 2.0 * size / static_cast<double>(options.width);
+  const double extent_y = 2.0 * size / static_cast<double>(options.height);
+  workload.vertices.reserve(triangles * 3);
+  workload.indices.reserve(triangles * 3);
+  workload.indices_32.reserve(triangles * 3);
+  for (size_t i = 0; i < triangles; ++i) {
+    const bool clipped = unit(rng) < clip_ratio;
+    double center_x = (unit(rng) * 2.0 - 1.0) * std::max(0.0, 1.0 - extent_x);
+    double center_y = (unit(rng) * 2.0 - 1.0) * std::max(0.0, 1.0 - extent_y);
+    double center_z = 0.1 + unit(rng) * 0.8;
+    const auto edge = static_cast<size_t>(unit(rng) * 3.0);
+    if (clipped && edge == 0) {
+      center_x = unit(rng) < 0.5 ? -1.0 : 1.0;
+    } else if (clipped && edge == 1) {
+      center_y = unit(rng) < 0.5 ? -1.0 : 1.0;
+    }
+    for (size_t k = 0; k < 3; ++k) {
+      const double angle = (static_cast<double>(k) + unit(rng) * 0.5) * 2.0943951023931953;
+      const double x = center_x + std::cos(angle) * extent_x * 0.5;
+      const double y = center_y + std::sin(angle) * extent_y * 0.5;
+      const double z = clipped && edge == 2 && k == 0 ? -center_z : center_z;
+      const double w = 1.0 + unit(rng);
+      Vertex vertex{};
+      vertex.pos = Vec4{static_cast<Real>(x * w), static_cast<Real>(y * w), static_cast<Real>(z * w), static_cast<Real>(w)};
+      vertex.col = Vec4{static_cast<Real>(unit(rng)), static_cast<Real>(unit(rng)), static_cast<Real>(unit(rng)), Real{1}};
+      vertex.tex = {static_cast<Real>(unit(rng)), static_cast<Real>(unit(rng))};
+      workload.indices.push_back(workload.vertices.size());
+      workload.indices_32.push_back(static_cast<uint32_t>(workload.vertices.size()));
+      workload.vertices.push_back(vertex);
+    }
+  }
+  return workload;
+}
+
+// Projects a generated solid, seen from -x like the default scene, into clip
+// space. Shared vertices stay shared, so the indexed stages see the reuse of a
+// real mesh.
+auto make_solid_workload(const Options &options, const std::string &description) -> Workload {
+  const auto solid = Vis::Solid::Generate(description);
+  const auto projection = glm::perspective(1.0, static_cast<double>(options.width) / static_cast<double>(options.height), 0.1, 100.0);
+  const auto view = glm::lookAt(glm::dvec3{-2.5, 0.0, 0.0}, glm::dvec3{0.0}, glm::dvec3{0.0, 1.0, 0.0});
+  const glm::dmat4 transform = projection * view * solid.matrix;
+  const Vis::Mat4 matrix{transform};
+  Workload workload{solid.indices.size() / 3};
+  workload.label = solid.name;
+  workload.vertices.reserve(solid.get_vertices().size());
+  for (auto vertex : solid.get_vertices()) {
+    vertex.pos = matrix * vertex.pos;
+    workload.vertices.push_back(vertex);
+  }
+  workload.indices.reserve(solid.indices.size());
+  workload.indices_32.reserve(solid.indices.size());
+  for (size_t i = 0; i < solid.indices.size(); ++i) {
+    workload.indices.push_back(solid.indices.get(i));
+    workload.indices_32.push_back(static_cast<uint32_t>(solid.indices.get(i)));
+  }
+  return workload;
+}
+
+size_t s_fragments{0};
+
+auto set_pixel_count(Vertex &, Image &) -> void { ++s_fragments; }
+
+class Bench {
+public:
+  Bench(const Options &options) : m_options{options}, m_image{options.width, options.height} {}
+
+  // Runs `stage` on a fresh copy of `input` every iteration and leaves the
+  // last output in `output`, so stages can be chained into realistic inputs.
+  auto run(const Workload &workload, const std::string &stage, const std::vector<Vertex> &input, std::vector<Vertex> &output, const std::function<void(std::vector<Vertex> &)> &function, const size_t pixels = 0) -> void {
+    run(workload, stage, input, input.size(), output, function, pixels);
+  }
+
+  // Same as above for stages that read the workload themselves, like the
+  // fetch stages, and process `vertices` vertices.
+  auto run(const Workload &workload, const std::string &stage, const std::vector<Vertex> &input, const size_t vertices, std::vector<Vertex> &output, const std::function<void(std::vector<Vertex> &)> &function, const size_t pixels = 0) -> void {
+    if (!m_options.filter.empty() && stage.find(m_options.filter) == std::string::npos) {
+      output = input;
+      function(output);
+      return;
+    }
+    std::vector<double> times;
+    times.reserve(m_options.iterations);
+    output.reserve(input.size() * 2);
+    for (size_t i = 0; i < m_options.iterations + 1; ++i) {
+      output.assign(input.begin(), input.end());
+      if (pixels != 0) {
+        m_image.clear();
+      }
+      double time{0.0};
+      {
+        Vis::Timer timer(&time);
+        function(output);
+      }
+      // The first run warms caches and the clip stages' scratch buffers.
+      if (i != 0) {
+        times.push_back(time * 1e9);
+      }
+    }
+    std::sort(times.begin(), times.end());
+    m_results.push_back({workload.name(), stage, vertices, pixels, times[times.size() / 2], times.front()});
+    if (m_options.json_path != "-") {
+      print(m_results.back());
+    }
+  }
+
+  [[nodiscard]] auto count_pixels(const std::vector<Vertex> &vertices, void (*rasterize)(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image))) -> size_t {
+    auto work = vertices;
+    s_fragments = 0;
+    rasterize(work, m_image, set_pixel_count);
+    return s_fragments;
+  }
+
+  [[nodiscard]] auto get_image() -> Image & { return m_image; }
+  [[nodiscard]] auto get_results() const -> const std::vector<Result> & { return m_results; }
+
+private:
+  auto print(const Result &result) const -> void {
+    std::printf("%-28s %-44s %10.1f us %8.2f ns/vertex", result.workload.c_str(), result.stage.c_str(), result.median_ns / 1000.0, result.median_ns / static_cast<double>(std::max<size_t>(result.vertices, 1)));
+    if (result.pixels != 0) {
+      std::printf(" %8.2f ns/pixel %8.1f Mpixel/s", result.median_ns / static_cast<double>(result.pixels), static_cast<double>(result.pixels) * 1000.0 / result.median_ns);
+    } else {
+      std::printf(" %8.1f Mvertex/s", static_cast<double>(result.vertices) * 1000.0 / result.median_ns);
+    }
+    std::printf("\n");
+  }
+
+private:
+  const Options &m_options;
+  Image m_image;
+  std::vector<Result> m_results{};
+};
+
+auto run_workload(Bench &bench, const Workload &workload) -> void {
+  namespace Alg = Vis::Alg;
+  const glm::dmat4 matrix{1.0};
+  auto &image = bench.get_image();
+  std::vector<Vertex> fetched;
+  std::vector<Vertex> scratch;
+  bench.run(workload, "fetch_vertices_indexed", {}, workload.indices.size(), scratch, [&](std::vector<Vertex> &v) { Alg::fetch_vertices_indexed(workload.vertices, workload.indices, matrix, v); });
+  bench.run(workload, "fetch_vertices_by_matrix", {}, workload.indices.size(), scratch, [&](std::vector<Vertex> &v) { Alg::fetch_vertices_by_matrix(workload.vertices, workload.indices, matrix, v); });
+  bench.run(workload, "fetch_triangles_by_stream", {}, workload.indices.size(), scratch, [&](std::vector<Vertex> &v) { Alg::fetch_triangles_by_stream(workload.vertices, workload.indices, matrix, v); });
+  const auto fetch_vertices_by_matrix_32 = Alg::specialize_fetch_vertices<uint32_t>(Alg::fetch_vertices_by_matrix);
+  bench.run(workload, "fetch_vertices_by_matrix_u32", {}, workload.indices.size(), scratch, [&](std::vector<Vertex> &v) { fetch_vertices_by_matrix_32(workload.vertices, workload.indices_32, matrix, v); });
+  Alg::fetch_vertices_indexed(workload.vertices, workload.indices, matrix, fetched);
+  bench.run(workload, "trasform_vertices_by_matrix", fetched, scratch, [&](std::vector<Vertex> &v) { Alg::trasform_vertices_by_matrix(v, matrix); });
+
+  // Triangles
+  std::vector<Vertex> fast;
+  std::vector<Vertex> before;
+  std::vector<Vertex> dehomog;
+  std::vector<Vertex> after;
+  std::vector<Vertex> viewport;
+  bench.run(workload, "clip_fast_triangle", fetched, fast, Alg::clip_fast_triangle);
+  bench.run(workload, "clip_backface_triangle", fast, scratch, Alg::clip_backface_triangle);
+  bench.run(workload, "clip_before_dehomog_triangle", fast, before, Alg::clip_before_dehomog_triangle);
+  bench.run(workload, "dehomog_pos", before, scratch, Alg::dehomog_pos);
+  bench.run(workload, "dehomog_all", before, dehomog, Alg::dehomog_all);
+  bench.run(workload, "clip_after_dehomog_guard_band", dehomog, scratch, Alg::clip_after_dehomog_guard_band);
+  bench.run(workload, "clip_after_dehomog_triangle", dehomog, after, Alg::clip_after_dehomog_triangle);
+  bench.run(workload, "trasform_to_viewport", after, viewport, [&](std::vector<Vertex> &v) { Alg::trasform_to_viewport(v, image); });
+  const auto pixels = bench.count_pixels(viewport, Alg::rasterize_triangle_edge);
+  for (const auto &[name, rasterize] : {std::pair{"rasterize_triangle", &Alg::rasterize_triangle}, std::pair{"rasterize_triangle_early_z", &Alg::rasterize_triangle_early_z}, std::pair{"rasterize_triangle_edge", &Alg::rasterize_triangle_edge}, std::pair{"rasterize_triangle_quad", &Alg::rasterize_triangle_quad}, std::pair{"rasterize_triangle_tiled", &Alg::rasterize_triangle_tiled}}) {
+    bench.run(workload, name, viewport, scratch, [&](std::vector<Vertex> &v) { rasterize(v, image, Alg::set_pixel_rgba_depth); }, pixels);
+  }
+  for (const auto &[name, set_pixel] : {std::pair{"set_pixel_none", &Alg::set_pixel_none}, std::pair{"set_pixel_rgba_depth", &Alg::set_pixel_rgba_depth}, std::pair{"set_pixel_rgba_no_depth", &Alg::set_pixel_rgba_no_depth}, std::pair{"set_pixel_z_depth", &Alg::set_pixel_z_depth}, std::pair{"set_pixel_z_no_depth", &Alg::set_pixel_z_no_depth}, std::pair{"set_pixel_tex", &Alg::set_pixel_tex}, std::pair{"set_pixel_white", &Alg::set_pixel_white}}) {
+    const auto rasterize = Alg::specialize_rasterize(Alg::rasterize_triangle_edge, set_pixel);
+    bench.run(workload, std::string{"rasterize_triangle_edge/"} + name, viewport, scratch, [&](std::vector<Vertex> &v) {
+      if (rasterize) {
+        rasterize(v, image);
+      } else {
+        Alg::rasterize_triangle_edge(v, image, set_pixel);
+      }
+    }, pixels);
+  }
+  bench.run(workload, "rasterize_triangle_as_lines", viewport, scratch, [&](std::vector<Vertex> &v) { Alg::rasterize_triangle_as_lines(v, image, Alg::set_pixel_rgba_depth); }, bench.count_pixels(viewport, Alg::rasterize_triangle_as_lines));
+
+  // Lines, built from the first two vertices of every triangle
+  std::vector<Vertex> lines;
+  lines.reserve(fetched.size() / 3 * 2);
+  for (size_t i = 0; i + 2 < fetched.size(); i += 3) {
+    lines.push_back(fetched[i]);
+    lines.push_back(fetched[i + 1]);
+  }
+  bench.run(workload, "clip_fast_line", lines, fast, Alg::clip_fast_line);
+  bench.run(workload, "clip_before_dehomog_line", fast, before, Alg::clip_before_dehomog_line);
+  Alg::dehomog_all(before);
+  bench.run(workload, "clip_after_dehomog_line", before, after, Alg::clip_after_dehomog_line);
+  Alg::trasform_to_viewport(after, image);
+  bench.run(workload, "rasterize_line", after, scratch, [&](std::vector<Vertex> &v) { Alg::rasterize_line(v, image, Alg::set_pixel_rgba_depth); }, bench.count_pixels(after, Alg::rasterize_line));
+
+  // Points
+  bench.run(workload, "clip_fast_point", fetched, fast, Alg::clip_fast_point);
+  Alg::dehomog_all(fast);
+  Alg::trasform_to_viewport(fast, image);
+  bench.run(workload, "rasterize_point", fast, scratch, [&](std::vector<Vertex> &v) { Alg::rasterize_point(v, image, Alg::set_pixel_rgba_depth); }, bench.count_pixels(fast, Alg::rasterize_point));
+}
+
+auto json_escape(const std::string &value) -> std::string {
+  std::string result;
+  for (const auto c : value) {
+    if (c == '"' || c == '\\') {
+      result.push_back('\\');
+    }
+    result.push_back(c);
+  }
+  return result;
+}
+
+auto write_json(std::ostream &out, const Options &options, const std::vector<Result> &results) -> void {
+  out << "{\n";
+  out << "  \"precision\": \"" << (sizeof(Real) == sizeof(float) ? "float" : "double") << "\",\n";
+  out << "  \"width\": " << options.width << ",\n";
+  out << "  \"height\": " << options.height << ",\n";
+  out << "  \"iterations\": " << options.iterations << ",\n";
+  out << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto &result = results[i];
+    const auto vertices = static_cast<double>(std::max<size_t>(result.vertices, 1));
+    out << "    {\"workload\": \"" << json_escape(result.workload) << "\", \"stage\": \"" << json_escape(result.stage) << "\"";
+    out << ", \"vertices\": " << result.vertices << ", \"pixels\": " << result.pixels;
+    out << ", \"median_ns\": " << result.median_ns << ", \"min_ns\": " << result.min_ns;
+    out << ", \"ns_per_vertex\": " << result.median_ns / vertices;
+    out << ", \"mvertices_per_s\": " << vertices * 1000.0 / result.median_ns;
+    if (result.pixels != 0) {
+      out << ", \"ns_per_pixel\": " << result.median_ns / static_cast<double>(result.pixels);
+      out << ", \"mpixels_per_s\": " << static_cast<double>(result.pixels) * 1000.0 / result.median_ns;
+    }
+    out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+}
+
+auto parse_size(const std::string_view value, const std::string_view name) -> size_t {
+  if (value.empty() || !std::all_of(value.begin(), value.end(), [](const char c) { return std::isdigit(c); })) {
+    throw std::runtime_error(std::string{name} + " argument is in wrong format!");
+  }
+  size_t result{0};
+  std::stringstream ss;
+  ss << value;
+  ss >> result;
+  if (result == 0) {
+    throw std::runtime_error(std::string{name} + " argument must be at least 1!");
+  }
+  return result;
+}
+
+auto parse_args(const std::vector<std::string_view> &args, Options &options) -> bool {
+  for (size_t i = 1; i < args.size(); ++i) {
+    const auto &arg = args[i];
+    const auto next = [&]() -> std::string_view {
+      if (i + 1 >= args.size()) {
+        throw std::runtime_error("Missing argument for " + std::string{arg});
+      }
+      return args[++i];
+    };
+    if (arg == "-h" || arg == "--help") {
+      std::cout << "VIS BENCH HELP:\n";
+      std::cout << " --help, -h: print help\n";
+      std::cout << " --res, -r: sets resolution (default 1280x720)\n";
+      std::cout << " --iterations, -i: timed runs per stage, the median is reported (default 10)\n";
+      std::cout << " --filter, -f: only times stages whose name contains the given text\n";
+      std::cout << " --json, -j: writes results as JSON to the given path, - for stdout\n";
+      std::cout << " --generate, -g: times a generated icosphere:<subdivisions>, grid:<cells>, torus:<sides> or cubesphere:<cells> instead of the random workloads, repeatable\n";
+      return true;
+    } else if (arg == "-r" || arg == "--res") {
+      const auto resolution = next();
+      const auto x = resolution.find('x');
+      if (x == std::string_view::npos) {
+        throw std::runtime_error("Resolution argument is in wrong format!");
+      }
+      options.width = parse_size(resolution.substr(0, x), "Resolution");
+      options.height = parse_size(resolution.substr(x + 1), "Resolution");
+    } else if (arg == "-i" || arg == "--iterations") {
+      options.iterations = parse_size(next(), "Iterations");
+    } else if (arg == "-f" || arg == "--filter") {
+      options.filter = next();
+    } else if (arg == "-j" || arg == "--json") {
+      options.json_path = next();
+    } else if (arg == "-g" || arg == "--generate") {
+      options.generated.emplace_back(next());
+    } else {
+      throw std::runtime_error("Unknown argument " + std::string{arg});
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  const std::vector<std::string_view> args(argv, argv + argc);
+  try {
+    Options options{};
+    if (parse_args(args, options)) {
+      return EXIT_SUCCESS;
+    }
+    Bench bench{options};
+    for (const auto &description : options.generated) {
+      run_workload(bench, make_solid_workload(options, description));
+    }
+    if (options.generated.empty()) {
+      for (const size_t triangles : {1'000, 10'000, 100'000}) {
+        for (const double size : {2.0, 8.0, 32.0, 128.0}) {
+          for (const double clip_ratio : {0.0, 0.25}) {
+            if (static_cast<double>(triangles) * size * size * 0.5 > options.pixel_budget) {
+              continue;
+            }
+            run_workload(bench, make_workload(options, triangles, size, clip_ratio));
+          }
+        }
+      }
+    }
+    if (options.json_path == "-") {
+      write_json(std::cout, options, bench.get_results());
+    } else if (!options.json_path.empty()) {
+      std::ofstream file(options.json_path);
+      if (!file) {
+        throw std::runtime_error("Cannot write \"" + options.json_path + "\"!");
+      }
+      write_json(file, options, bench.get_results());
+    }
+  } catch (...) {
+    return Vis::handle_exception();
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+// Compares two frames written with `VIS --dump <path>`, typically one from a
+// double build and one from a VIS_FLOAT_PRECISION build of the same scene.
+#include "main.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Frame {
+  size_t width{0};
+  size_t height{0};
+  std::vector<uint8_t> color{};
+  std::vector<double> depth{};
+};
+
+auto load_frame(const std::string &path) -> Frame {
+  std::ifstream color_file(path + ".ppm", std::ios::binary);
+  std::ifstream depth_file(path + ".depth", std::ios::binary);
+  if (!color_file || !depth_file) {
+    throw std::runtime_error("Cannot read frame \"" + path + "\"!");
+  }
+  Frame frame;
+  std::string magic;
+  size_t max_value{0};
+  color_file >> magic >> frame.width >> frame.height >> max_value;
+  if (magic != "P6" || max_value != 255 || color_file.get() != '\n') {
+    throw std::runtime_error("Frame \"" + path + ".ppm\" is in wrong format!");
+  }
+  frame.color.resize(frame.width * frame.height * 3);
+  color_file.read(reinterpret_cast<char *>(frame.color.data()), static_cast<std::streamsize>(frame.color.size()));
+  size_t width{0};
+  size_t height{0};
+  depth_file >> magic >> width >> height;
+  if (magic != "VISDEPTH" || width != frame.width || height != frame.height || depth_file.get() != '\n') {
+    throw std::runtime_error("Frame \"" + path + ".depth\" is in wrong format!");
+  }
+  frame.depth.resize(frame.width * frame.height);
+  depth_file.read(reinterpret_cast<char *>(frame.depth.data()), static_cast<std::streamsize>(frame.depth.size() * sizeof(double)));
+  if (!color_file || !depth_file) {
+    throw std::runtime_error("Frame \"" + path + "\" is truncated!");
+  }
+  return frame;
+}
+
+auto compare(const Frame &reference, const Frame &candidate) -> bool {
+  if (reference.width != candidate.width || reference.height != candidate.height) {
+    throw std::runtime_error("Frames have different resolution!");
+  }
+  const auto pixels = reference.width * reference.height;
+  size_t color_differing{0};
+  int max_color_error{0};
+  double squared_error{0.0};
+  for (size_t i = 0; i < pixels; ++i) {
+    int pixel_error{0};
+    for (size_t c = 0; c < 3; ++c) {
+      const auto error = std::abs(static_cast<int>(reference.color[i * 3 + c]) - static_cast<int>(candidate.color[i * 3 + c]));
+      pixel_error = std::max(pixel_error, error);
+      squared_error += static_cast<double>(error * error);
+    }
+    max_color_error = std::max(max_color_error, pixel_error);
+    color_differing += pixel_error != 0;
+  }
+  size_t depth_differing{0};
+  size_t depth_covered{0};
+  double max_depth_error{0.0};
+  double sum_depth_error{0.0};
+  for (size_t i = 0; i < pixels; ++i) {
+    const auto error = std::abs(reference.depth[i] - candidate.depth[i]);
+    depth_covered += reference.depth[i] < 1.0 || candidate.depth[i] < 1.0;
+    depth_differing += error != 0.0;
+    max_depth_error = std::max(max_depth_error, error);
+    sum_depth_error += error;
+  }
+  const auto mse = squared_error / static_cast<double>(pixels * 3);
+  const auto to_percent = [pixels](const size_t count) { return 100.0 * static_cast<double>(count) / static_cast<double>(pixels); };
+  std::printf("resolution: %zux%zu\n", reference.width, reference.height);
+  std::printf("color: differing %zu (%.3f%%), max error %d, rmse %.4f, psnr %s\n", color_differing, to_percent(color_differing), max_color_error, std::sqrt(mse),
+              mse == 0.0 ? "inf" : (std::to_string(10.0 * std::log10(255.0 * 255.0 / mse)) + " dB").c_str());
+  std::printf("depth: covered %zu, differing %zu (%.3f%%), max error %.3e, mean error %.3e\n", depth_covered, depth_differing, to_percent(depth_differing), max_depth_error,
+              depth_covered == 0 ? 0.0 : sum_depth_error / static_cast<double>(depth_covered));
+  return color_differing == 0 && depth_differing == 0;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  const std::vector<std::string_view> args(argv, argv + argc);
+  try {
+    if (args.size() != 3) {
+      std::printf("usage: vis_compare <reference> <candidate>\n");
+      std::printf(" compares <path>.ppm and <path>.depth written by VIS --dump <path>\n");
+      return EXIT_FAILURE;
+    }
+    return compare(load_frame(std::string{args[1]}), load_frame(std::string{args[2]})) ? EXIT_SUCCESS : 2;
+  } catch (...) {
+    return Vis::handle_exception();
+  }
+}
@@ -0,0 +1,35 @@
+// Converts an OBJ, PLY or .vis mesh into the native .vis format, which
+// `--mesh` loads without parsing.
+#include "main.hpp"
+#include "mesh_loader.hpp"
+#include "solid_file.hpp"
+#include "timer.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+auto main(int argc, char **argv) -> int {
+  const std::vector<std::string_view> args(argv, argv + argc);
+  try {
+    if (args.size() != 3) {
+      std::printf("usage: vis_convert <input> <output.vis>\n");
+      std::printf(" converts an .obj, binary .ply or .vis mesh into a .vis solid\n");
+      return EXIT_FAILURE;
+    }
+    Vis::MeshLoadStats stats{};
+    const auto solid = Vis::load_mesh(std::string{args[1]}, &stats);
+    std::cout << "Loaded " << solid.name << ": " << stats;
+    double seconds{0.0};
+    {
+      Vis::Timer timer{&seconds};
+      Vis::save_solid(solid, std::string{args[2]});
+    }
+    std::cout << "Saved " << args[2] << " in " << seconds << " s\n";
+  } catch (...) {
+    return Vis::handle_exception();
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "fragment.hpp"
+#include "fragment_kernels.hpp"
+#include "pipeline.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#endif
+
+namespace Vis {
+namespace {
+SimdLevel s_simd_level{Alg::detect_simd_level()};
+} // namespace
+
+auto quad_shaders_scalar() -> QuadShaders { return make_quad_shaders<ScalarOps>(); }
+
+#if defined(__x86_64__) || defined(_M_X64)
+auto quad_shaders_sse2() -> QuadShaders { return make_quad_shaders<Sse2Ops>(); }
+#else
+auto quad_shaders_sse2() -> QuadShaders { return {}; }
+#endif
+
+namespace Alg {
+
+auto detect_simd_level() -> SimdLevel {
+  if (quad_shaders_avx2().rgba_depth) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (__builtin_cpu_supports("avx2")) {
+      return SimdLevel::Avx2;
+    }
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4]{};
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+      __cpuid(info, 1);
+      const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+      __cpuidex(info, 7, 0);
+      if (os_saves_ymm && (info[1] & (1 << 5))) {
+        return SimdLevel::Avx2;
+      }
+    }
+#endif
+  }
+  if (quad_shaders_sse2().rgba_depth) {
+    return SimdLevel::Sse2;
+  }
+  return SimdLevel::Scalar;
+}
+
+auto get_simd_level() -> SimdLevel { return s_simd_level; }
+
+auto set_simd_level(const SimdLevel level) -> void {
+  s_simd_level = std::min(level, detect_simd_level());
+}
+
+auto quad_shader(void (*set_pixel)(Vertex &vertex, Image &image)) -> QuadShader {
+  static const QuadShaders s_scalar{quad_shaders_scalar()};
+  static const QuadShaders s_sse2{quad_shaders_sse2()};
+  static const QuadShaders s_avx2{quad_shaders_avx2()};
+  const QuadShaders *shaders{&s_scalar};
+  switch (s_simd_level) {
+  case SimdLevel::Scalar: {
+    shaders = &s_scalar;
+  } break;
+  case SimdLevel::Sse2: {
+    shaders = &s_sse2;
+  } break;
+  case SimdLevel::Avx2: {
+    shaders = &s_avx2;
+  } break;
+  }
+  if (set_pixel == set_pixel_rgba_depth) {
+    return shaders->rgba_depth;
+  }
+  if (set_pixel == set_pixel_rgba_no_depth) {
+    return shaders->rgba_no_depth;
+  }
+  if (set_pixel == set_pixel_z_depth) {
+    return shaders->z_depth;
+  }
+  if (set_pixel == set_pixel_z_no_depth) {
+    return shaders->z_no_depth;
+  }
+  if (set_pixel == set_pixel_tex) {
+    return shaders->tex;
+  }
+  if (set_pixel == set_pixel_white) {
+    return shaders->white;
+  }
+  return nullptr;
+}
+
+} // namespace Alg
+} // namespace Vis
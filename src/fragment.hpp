@@ -0,0 +1,48 @@
+#pragma once
+
+#include "image.hpp"
+#include "vertex.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace Vis {
+
+enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+// A run of up to `width` horizontally adjacent fragments, one lane per pixel.
+struct FragmentQuad {
+  static constexpr size_t width{8};
+  size_t count{0};
+  alignas(32) std::array<Real, width> z{};
+  alignas(32) std::array<Real, width> r{};
+  alignas(32) std::array<Real, width> g{};
+  alignas(32) std::array<Real, width> b{};
+  alignas(32) std::array<Real, width> a{};
+  alignas(32) std::array<Real, width> one{};
+};
+
+// `color` and `depth` point at the buffer element of the quad's first lane.
+using QuadShader = void (*)(const FragmentQuad &quad, ColorRGBA8 *color, Real *depth);
+
+struct QuadShaders {
+  QuadShader rgba_depth{nullptr};
+  QuadShader rgba_no_depth{nullptr};
+  QuadShader z_depth{nullptr};
+  QuadShader z_no_depth{nullptr};
+  QuadShader tex{nullptr};
+  QuadShader white{nullptr};
+};
+
+auto quad_shaders_scalar() -> QuadShaders;
+auto quad_shaders_sse2() -> QuadShaders;
+auto quad_shaders_avx2() -> QuadShaders;
+
+namespace Alg {
+auto detect_simd_level() -> SimdLevel;
+auto get_simd_level() -> SimdLevel;
+auto set_simd_level(SimdLevel level) -> void;
+auto quad_shader(void (*set_pixel)(Vertex &vertex, Image &image)) -> QuadShader;
+} // namespace Alg
+
+} // namespace Vis
@@ -0,0 +1,11 @@
+#include "fragment_kernels.hpp"
+
+namespace Vis {
+
+#if defined(__AVX2__)
+auto quad_shaders_avx2() -> QuadShaders { return make_quad_shaders<Avx2Ops>(); }
+#else
+auto quad_shaders_avx2() -> QuadShaders { return {}; }
+#endif
+
+} // namespace Vis
@@ -0,0 +1,283 @@
+#pragma once
+// Shared by fragment.cpp and fragment_avx2.cpp, which is compiled with AVX2
+// enabled. Everything stays in an anonymous namespace so neither translation
+// unit can pick up the other's instantiations.
+#include "fragment.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  include <immintrin.h>
+#endif
+
+#include <array>
+#include <type_traits>
+
+namespace Vis {
+namespace {
+
+struct ScalarOps {
+  using V = Real;
+  using M = bool;
+  static constexpr size_t width{1};
+  static inline auto load(const Real *p) -> V { return *p; }
+  static inline auto set1(const Real v) -> V { return v; }
+  static inline auto div(const V a, const V b) -> V { return a / b; }
+  static inline auto all() -> M { return true; }
+  static inline auto none(const M m) -> bool { return !m; }
+  static inline auto not_greater(const V a, const V b) -> M { return !(a > b); }
+  static inline auto even(const V v) -> M { return static_cast<int>(v * 10) % 2 == 0; }
+  static inline auto and_(const M a, const M b) -> M { return a && b; }
+  static inline auto or_(const M a, const M b) -> M { return a || b; }
+  static inline auto not_(const M a) -> M { return !a; }
+  static inline auto select(const M m, const V a, const V b) -> V { return m ? a : b; }
+  static inline auto store_depth(Real *p, const V z, const M m) -> void {
+    if (m) {
+      *p = z;
+    }
+  }
+  static inline auto store_color(ColorRGBA8 *p, const V r, const V g, const V b, const V a, const M m) -> void {
+    if (m) {
+      *p = {static_cast<uint8_t>(r * 255.999), static_cast<uint8_t>(g * 255.999), static_cast<uint8_t>(b * 255.999), static_cast<uint8_t>(a * 255.999)};
+    }
+  }
+};
+
+#if defined(__x86_64__) || defined(_M_X64)
+// Color stores never read the target back: it may be a write only mapping of
+// uncached memory. Partial quads write their covered lanes one at a time
+// instead of blending with what is already there.
+inline auto store_color_lanes(ColorRGBA8 *p, const __m128i rgba, const int bits) -> void {
+  alignas(16) std::array<ColorRGBA8, 4> lanes;
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes.data()), rgba);
+  for (size_t i = 0; i < lanes.size(); ++i) {
+    if (bits & (1 << i)) {
+      p[i] = lanes[i];
+    }
+  }
+}
+
+struct Sse2DoubleOps {
+  using V = __m128d;
+  using M = __m128d;
+  static constexpr size_t width{2};
+  static inline auto load(const double *p) -> V { return _mm_loadu_pd(p); }
+  static inline auto set1(const double v) -> V { return _mm_set1_pd(v); }
+  static inline auto div(const V a, const V b) -> V { return _mm_div_pd(a, b); }
+  static inline auto all() -> M { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+  static inline auto none(const M m) -> bool { return _mm_movemask_pd(m) == 0; }
+  static inline auto not_greater(const V a, const V b) -> M { return _mm_cmpngt_pd(a, b); }
+  static inline auto even(const V v) -> M {
+    const auto i = _mm_cvttpd_epi32(_mm_mul_pd(v, _mm_set1_pd(10.0)));
+    const auto e = _mm_cmpeq_epi32(_mm_and_si128(i, _mm_set1_epi32(1)), _mm_setzero_si128());
+    return _mm_castsi128_pd(_mm_unpacklo_epi32(e, e));
+  }
+  static inline auto and_(const M a, const M b) -> M { return _mm_and_pd(a, b); }
+  static inline auto or_(const M a, const M b) -> M { return _mm_or_pd(a, b); }
+  static inline auto not_(const M a) -> M { return _mm_xor_pd(a, all()); }
+  static inline auto select(const M m, const V a, const V b) -> V { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+  static inline auto store_depth(double *p, const V z, const M m) -> void { _mm_storeu_pd(p, select(m, z, _mm_loadu_pd(p))); }
+  static inline auto to_byte(const V c) -> __m128i { return _mm_and_si128(_mm_cvttpd_epi32(_mm_mul_pd(c, _mm_set1_pd(255.999))), _mm_set1_epi32(0xff)); }
+  static inline auto store_color(ColorRGBA8 *p, const V r, const V g, const V b, const V a, const M m) -> void {
+    const auto rgba = _mm_or_si128(_mm_or_si128(to_byte(r), _mm_slli_epi32(to_byte(g), 8)), _mm_or_si128(_mm_slli_epi32(to_byte(b), 16), _mm_slli_epi32(to_byte(a), 24)));
+    const auto bits = _mm_movemask_pd(m);
+    if (bits == 0x3) {
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(p), rgba);
+    } else {
+      store_color_lanes(p, rgba, bits);
+    }
+  }
+};
+
+// Float lanes are widened to double before the byte conversion so the result
+// matches the scalar `color * 255.999` in Image exactly.
+struct Sse2FloatOps {
+  using V = __m128;
+  using M = __m128;
+  static constexpr size_t width{4};
+  static inline auto load(const float *p) -> V { return _mm_loadu_ps(p); }
+  static inline auto set1(const float v) -> V { return _mm_set1_ps(v); }
+  static inline auto div(const V a, const V b) -> V { return _mm_div_ps(a, b); }
+  static inline auto all() -> M { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+  static inline auto none(const M m) -> bool { return _mm_movemask_ps(m) == 0; }
+  static inline auto not_greater(const V a, const V b) -> M { return _mm_cmpngt_ps(a, b); }
+  static inline auto even(const V v) -> M {
+    const auto i = _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(10.0f)));
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(i, _mm_set1_epi32(1)), _mm_setzero_si128()));
+  }
+  static inline auto and_(const M a, const M b) -> M { return _mm_and_ps(a, b); }
+  static inline auto or_(const M a, const M b) -> M { return _mm_or_ps(a, b); }
+  static inline auto not_(const M a) -> M { return _mm_xor_ps(a, all()); }
+  static inline auto select(const M m, const V a, const V b) -> V { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+  static inline auto store_depth(float *p, const V z, const M m) -> void { _mm_storeu_ps(p, select(m, z, _mm_loadu_ps(p))); }
+  static inline auto to_byte(const V c) -> __m128i {
+    const auto scale = _mm_set1_pd(255.999);
+    const auto lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(c), scale));
+    const auto hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(c, c)), scale));
+    return _mm_and_si128(_mm_unpacklo_epi64(lo, hi), _mm_set1_epi32(0xff));
+  }
+  static inline auto store_color(ColorRGBA8 *p, const V r, const V g, const V b, const V a, const M m) -> void {
+    const auto rgba = _mm_or_si128(_mm_or_si128(to_byte(r), _mm_slli_epi32(to_byte(g), 8)), _mm_or_si128(_mm_slli_epi32(to_byte(b), 16), _mm_slli_epi32(to_byte(a), 24)));
+    const auto bits = _mm_movemask_ps(m);
+    if (bits == 0xf) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(p), rgba);
+    } else {
+      store_color_lanes(p, rgba, bits);
+    }
+  }
+};
+
+using Sse2Ops = std::conditional_t<std::is_same_v<Real, float>, Sse2FloatOps, Sse2DoubleOps>;
+#endif
+
+#if defined(__AVX2__)
+struct Avx2DoubleOps {
+  using V = __m256d;
+  using M = __m256d;
+  static constexpr size_t width{4};
+  static inline auto load(const double *p) -> V { return _mm256_loadu_pd(p); }
+  static inline auto set1(const double v) -> V { return _mm256_set1_pd(v); }
+  static inline auto div(const V a, const V b) -> V { return _mm256_div_pd(a, b); }
+  static inline auto all() -> M { return _mm256_castsi256_pd(_mm256_set1_epi32(-1)); }
+  static inline auto none(const M m) -> bool { return _mm256_movemask_pd(m) == 0; }
+  static inline auto not_greater(const V a, const V b) -> M { return _mm256_cmp_pd(a, b, _CMP_NGT_UQ); }
+  static inline auto even(const V v) -> M {
+    const auto i = _mm256_cvttpd_epi32(_mm256_mul_pd(v, _mm256_set1_pd(10.0)));
+    const auto e = _mm_cmpeq_epi32(_mm_and_si128(i, _mm_set1_epi32(1)), _mm_setzero_si128());
+    return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(e));
+  }
+  static inline auto and_(const M a, const M b) -> M { return _mm256_and_pd(a, b); }
+  static inline auto or_(const M a, const M b) -> M { return _mm256_or_pd(a, b); }
+  static inline auto not_(const M a) -> M { return _mm256_xor_pd(a, all()); }
+  static inline auto select(const M m, const V a, const V b) -> V { return _mm256_blendv_pd(b, a, m); }
+  static inline auto store_depth(double *p, const V z, const M m) -> void { _mm256_storeu_pd(p, select(m, z, _mm256_loadu_pd(p))); }
+  static inline auto to_byte(const V c) -> __m128i { return _mm_and_si128(_mm256_cvttpd_epi32(_mm256_mul_pd(c, _mm256_set1_pd(255.999))), _mm_set1_epi32(0xff)); }
+  static inline auto store_color(ColorRGBA8 *p, const V r, const V g, const V b, const V a, const M m) -> void {
+    const auto rgba = _mm_or_si128(_mm_or_si128(to_byte(r), _mm_slli_epi32(to_byte(g), 8)), _mm_or_si128(_mm_slli_epi32(to_byte(b), 16), _mm_slli_epi32(to_byte(a), 24)));
+    const auto mask = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(m), _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0)));
+    _mm_maskstore_epi32(reinterpret_cast<int *>(p), mask, rgba);
+  }
+};
+struct Avx2FloatOps {
+  using V = __m256;
+  using M = __m256;
+  static constexpr size_t width{8};
+  static inline auto load(const float *p) -> V { return _mm256_loadu_ps(p); }
+  static inline auto set1(const float v) -> V { return _mm256_set1_ps(v); }
+  static inline auto div(const V a, const V b) -> V { return _mm256_div_ps(a, b); }
+  static inline auto all() -> M { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+  static inline auto none(const M m) -> bool { return _mm256_movemask_ps(m) == 0; }
+  static inline auto not_greater(const V a, const V b) -> M { return _mm256_cmp_ps(a, b, _CMP_NGT_UQ); }
+  static inline auto even(const V v) -> M {
+    const auto i = _mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(10.0f)));
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(i, _mm256_set1_epi32(1)), _mm256_setzero_si256()));
+  }
+  static inline auto and_(const M a, const M b) -> M { return _mm256_and_ps(a, b); }
+  static inline auto or_(const M a, const M b) -> M { return _mm256_or_ps(a, b); }
+  static inline auto not_(const M a) -> M { return _mm256_xor_ps(a, all()); }
+  static inline auto select(const M m, const V a, const V b) -> V { return _mm256_blendv_ps(b, a, m); }
+  static inline auto store_depth(float *p, const V z, const M m) -> void { _mm256_storeu_ps(p, select(m, z, _mm256_loadu_ps(p))); }
+  static inline auto to_byte(const V c) -> __m256i {
+    const auto scale = _mm256_set1_pd(255.999);
+    const auto lo = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(c)), scale));
+    const auto hi = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(c, 1)), scale));
+    return _mm256_and_si256(_mm256_set_m128i(hi, lo), _mm256_set1_epi32(0xff));
+  }
+  static inline auto store_color(ColorRGBA8 *p, const V r, const V g, const V b, const V a, const M m) -> void {
+    const auto rgba = _mm256_or_si256(_mm256_or_si256(to_byte(r), _mm256_slli_epi32(to_byte(g), 8)), _mm256_or_si256(_mm256_slli_epi32(to_byte(b), 16), _mm256_slli_epi32(to_byte(a), 24)));
+    _mm256_maskstore_epi32(reinterpret_cast<int *>(p), _mm256_castps_si256(m), rgba);
+  }
+};
+
+using Avx2Ops = std::conditional_t<std::is_same_v<Real, float>, Avx2FloatOps, Avx2DoubleOps>;
+#endif
+
+// Each shader mirrors the Alg::set_pixel_* function of the same name lane by lane.
+struct ShadeRgbaDepth {
+  template <typename Ops> static inline auto shade(const FragmentQuad &quad, ColorRGBA8 *color, Real *depth, const size_t i) -> void {
+    const auto z = Ops::load(&quad.z[i]);
+    const auto mask = Ops::not_greater(z, Ops::load(depth + i));
+    if (Ops::none(mask)) {
+      return;
+    }
+    const auto one = Ops::load(&quad.one[i]);
+    Ops::store_depth(depth + i, z, mask);
+    Ops::store_color(color + i, Ops::div(Ops::load(&quad.r[i]), one), Ops::div(Ops::load(&quad.g[i]), one), Ops::div(Ops::load(&quad.b[i]), one), Ops::div(Ops::load(&quad.a[i]), one), mask);
+  }
+};
+
+struct ShadeRgbaNoDepth {
+  template <typename Ops> static inline auto shade(const FragmentQuad &quad, ColorRGBA8 *color, Real *, const size_t i) -> void {
+    const auto one = Ops::load(&quad.one[i]);
+    Ops::store_color(color + i, Ops::div(Ops::load(&quad.r[i]), one), Ops::div(Ops::load(&quad.g[i]), one), Ops::div(Ops::load(&quad.b[i]), one), Ops::div(Ops::load(&quad.a[i]), one), Ops::all());
+  }
+};
+
+struct ShadeZDepth {
+  template <typename Ops> static inline auto shade(const FragmentQuad &quad, ColorRGBA8 *color, Real *depth, const size_t i) -> void {
+    const auto z = Ops::load(&quad.z[i]);
+    const auto mask = Ops::not_greater(z, Ops::load(depth + i));
+    if (Ops::none(mask)) {
+      return;
+    }
+    Ops::store_depth(depth + i, z, mask);
+    Ops::store_color(color + i, z, z, z, Ops::set1(1.0), mask);
+  }
+};
+
+struct ShadeZNoDepth {
+  template <typename Ops> static inline auto shade(const FragmentQuad &quad, ColorRGBA8 *color, Real *, const size_t i) -> void {
+    const auto z = Ops::load(&quad.z[i]);
+    Ops::store_color(color + i, z, z, z, Ops::set1(1.0), Ops::all());
+  }
+};
+
+struct ShadeTex {
+  template <typename Ops> static inline auto shade(const FragmentQuad &quad, ColorRGBA8 *color, Real *depth, const size_t i) -> void {
+    const auto z = Ops::load(&quad.z[i]);
+    const auto mask = Ops::not_greater(z, Ops::load(depth + i));
+    if (Ops::none(mask)) {
+      return;
+    }
+    const auto one = Ops::load(&quad.one[i]);
+    const auto r = Ops::div(Ops::load(&quad.r[i]), one);
+    const auto g = Ops::div(Ops::load(&quad.g[i]), one);
+    const auto b = Ops::div(Ops::load(&quad.b[i]), one);
+    const auto r_t = Ops::even(r);
+    const auto g_t = Ops::even(g);
+    const auto b_t = Ops::even(b);
+    const auto white = Ops::or_(Ops::or_(Ops::and_(Ops::and_(r_t, g_t), Ops::not_(b_t)), Ops::and_(Ops::and_(r_t, Ops::not_(g_t)), b_t)), Ops::and_(Ops::and_(Ops::not_(r_t), g_t), b_t));
+    const auto full = Ops::set1(1.0);
+    Ops::store_depth(depth + i, z, mask);
+    Ops::store_color(color + i, Ops::select(white, full, r), Ops::select(white, full, g), Ops::select(white, full, b), full, mask);
+  }
+};
+
+struct ShadeWhite {
+  template <typename Ops> static inline auto shade(const FragmentQuad &, ColorRGBA8 *color, Real *, const size_t i) -> void {
+    const auto full = Ops::set1(1.0);
+    Ops::store_color(color + i, full, full, full, full, Ops::all());
+  }
+};
+
+template <typename Ops, typename Shade> auto shade_quad(const FragmentQuad &quad, ColorRGBA8 *color, Real *depth) -> void {
+  size_t i = 0;
+  for (; i + Ops::width <= quad.count; i += Ops::width) {
+    Shade::template shade<Ops>(quad, color, depth, i);
+  }
+  for (; i < quad.count; ++i) {
+    Shade::template shade<ScalarOps>(quad, color, depth, i);
+  }
+}
+
+template <typename Ops> auto make_quad_shaders() -> QuadShaders {
+  return {
+    .rgba_depth = shade_quad<Ops, ShadeRgbaDepth>,
+    .rgba_no_depth = shade_quad<Ops, ShadeRgbaNoDepth>,
+    .z_depth = shade_quad<Ops, ShadeZDepth>,
+    .z_no_depth = shade_quad<Ops, ShadeZNoDepth>,
+    .tex = shade_quad<Ops, ShadeTex>,
+    .white = shade_quad<Ops, ShadeWhite>,
+  };
+}
+
+} // namespace
+} // namespace Vis
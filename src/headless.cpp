@@ -0,0 +1,55 @@
+#include "main.hpp"
+#include "render_options.hpp"
+#include "renderer.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+auto parse_args(const std::vector<std::string_view> &args, Vis::HeadlessInfo &headless_info, Vis::SceneOptions &scene_options) -> bool {
+  for (size_t i = 1; i < args.size(); ++i) {
+    const auto &arg = args[i];
+    const auto next = [&]() -> std::string_view {
+      if (i + 1 >= args.size() || args[i + 1][0] == '-') {
+        throw std::runtime_error("Missing argument for " + std::string{arg});
+      }
+      return args[++i];
+    };
+    if (arg == "-h" || arg == "--help") {
+      std::cout << "VIS HEADLESS HELP:\n";
+      std::cout << " --help, -h: print help\n";
+      Vis::print_render_options_help(std::cout);
+      return true;
+    } else if (!Vis::parse_render_option(arg, next, headless_info, scene_options)) {
+      throw std::runtime_error("Unknown argument " + std::string{arg});
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  const std::vector<std::string_view> args(argv, argv + argc);
+  try {
+    Vis::HeadlessInfo headless_info{};
+    Vis::SceneOptions scene_options{};
+    if (parse_args(args, headless_info, scene_options)) {
+      return EXIT_SUCCESS;
+    }
+    auto scene_info = Vis::SceneInfo::Default(headless_info.width, headless_info.height);
+    Vis::apply_scene_options(scene_options, scene_info);
+    Vis::Renderer renderer{};
+    const auto total_time = renderer.render_frames(scene_info, headless_info);
+    std::cout << "Rendered " << headless_info.frames << " frames at " << headless_info.width << 'x' << headless_info.height << " in " << total_time << " s (" << total_time * 1000.0 / static_cast<double>(headless_info.frames) << " ms/frame)\n";
+    if (headless_info.stats) {
+      std::cout << renderer.get_stats();
+    }
+  } catch (...) {
+    return Vis::handle_exception();
+  }
+  return EXIT_SUCCESS;
+}
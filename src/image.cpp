@@ -1,48 +1,118 @@
 #include "image.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+
 namespace Vis {
 Image::Image() {}
 Image::Image(const size_t width, const size_t height)
     : m_width(width), m_height(height) {
-  m_color_buffer.resize(width * height);
-  m_depth_buffer.resize(width * height);
+  resize_color_buffer();
+  resize_depth_buffer();
+  resize_depth_tiles();
+  resize_tiles();
 }
 
 auto Image::resize(const size_t width, const size_t height) -> void {
   m_width = width;
   m_height = height;
-  m_color_buffer.resize(width * height);
-  m_depth_buffer.resize(width * height);
+  resize_color_buffer();
+  resize_depth_buffer();
+  resize_depth_tiles();
+  resize_tiles();
 }
 
-auto Image::clear(const glm::dvec4 &color, const double depth) -> void {
-  for (auto &pixel : m_color_buffer) {
-    pixel = dvec4_to_rgba8(color);
+auto Image::set_depth_format(const DepthFormat depth_format) -> void {
+  if (depth_format == m_depth_format) {
+    return;
   }
-  for (auto &value : m_depth_buffer) {
-    value = depth;
+  m_depth_format = depth_format;
+  resize_depth_buffer();
+  m_depth_buffer.shrink_to_fit();
+  m_depth_buffer_16.shrink_to_fit();
+  m_depth_buffer_32.shrink_to_fit();
+  std::fill(m_depth_tiles_dirty.begin(), m_depth_tiles_dirty.end(), 1);
+}
+
+auto Image::clear(const glm::dvec4 &color, const Real depth) -> void {
+  m_clear_color = dvec4_to_rgba8(color);
+  switch (m_depth_format) {
+  case DepthFormat::Native: {
+    m_clear_depth = depth;
+  } break;
+  case DepthFormat::D16: {
+    m_clear_depth = static_cast<Real>(encode_d16(depth)) / d16_max;
+  } break;
+  case DepthFormat::D24: {
+    m_clear_depth = static_cast<Real>(encode_d24(depth)) / d24_max;
+  } break;
+  case DepthFormat::D32F: {
+    m_clear_depth = static_cast<Real>(std::bit_cast<float>(encode_d32f(depth)));
+  } break;
   }
+  std::fill(m_tiles_cleared.begin(), m_tiles_cleared.end(), 1);
+  std::fill(m_depth_tiles.begin(), m_depth_tiles.end(), DepthTile{m_clear_depth, m_clear_depth});
+  std::fill(m_depth_tiles_dirty.begin(), m_depth_tiles_dirty.end(), 0);
 }
 
-auto Image::set_pixel(const size_t x, const size_t y,
-                      const glm::dvec4 &color) -> void {
-  if (x >= m_width || y >= m_height) {
+auto Image::resolve() -> void {
+  for (size_t tile_y = 0; tile_y < m_tiles_y; ++tile_y) {
+    // Runs of cleared tiles are filled together, a fully cleared tile row as one contiguous block.
+    for (size_t tile_x = 0; tile_x < m_tiles_x; ++tile_x) {
+      if (!m_tiles_cleared[tile_x + tile_y * m_tiles_x]) {
+        continue;
+      }
+      auto end_x = tile_x;
+      while (end_x < m_tiles_x && m_tiles_cleared[end_x + tile_y * m_tiles_x]) {
+        m_tiles_cleared[end_x + tile_y * m_tiles_x] = 0;
+        ++end_x;
+      }
+      fill_cleared(tile_x * tile_size, std::min(end_x * tile_size, m_width), tile_y);
+      tile_x = end_x;
+    }
+  }
+}
+
+auto Image::resolve(const size_t min_x, const size_t min_y, const size_t max_x,
+                    const size_t max_y) -> void {
+  if (m_tiles_cleared.empty()) {
     return;
   }
-  m_color_buffer[x + y * m_width] = dvec4_to_rgba8(color);
+  const auto max_tile_x = std::min(max_x / tile_size, m_tiles_x - 1);
+  const auto max_tile_y = std::min(max_y / tile_size, m_tiles_y - 1);
+  for (auto tile_y = min_y / tile_size; tile_y <= max_tile_y; ++tile_y) {
+    for (auto tile_x = min_x / tile_size; tile_x <= max_tile_x; ++tile_x) {
+      if (m_tiles_cleared[tile_x + tile_y * m_tiles_x]) {
+        resolve_tile(tile_x, tile_y);
+      }
+    }
+  }
 }
-auto Image::set_depth(const size_t x, const size_t y,
-                      const double depth) -> void {
+
+auto Image::set_pixel(const size_t x, const size_t y,
+                      const glm::dvec4 &color) -> void {
   if (x >= m_width || y >= m_height) {
     return;
   }
-  m_depth_buffer[x + y * m_width] = depth;
+  if (m_tiles_cleared[tile_index(x, y)]) {
+    resolve_tile(x / tile_size, y / tile_size);
+  }
+  p_color[x + y * m_width] = dvec4_to_rgba8(color);
 }
 
 [[nodiscard]] auto Image::get_width() const -> size_t { return m_width; }
 [[nodiscard]] auto Image::get_height() const -> size_t { return m_height; }
 [[nodiscard]] auto Image::get_image_data() -> ColorRGBA8 * {
-  return m_color_buffer.data();
+  return p_color;
+}
+[[nodiscard]] auto Image::get_depth_data() -> Real * {
+  return m_depth_format == DepthFormat::Native ? m_depth_buffer.data() : nullptr;
+}
+[[nodiscard]] auto Image::get_depth_format() const -> DepthFormat { return m_depth_format; }
+[[nodiscard]] auto Image::get_depth_buffer_size() const -> size_t {
+  return m_depth_buffer.size() * sizeof(Real) + m_depth_buffer_16.size() * sizeof(uint16_t) + m_depth_buffer_32.size() * sizeof(uint32_t);
 }
 [[nodiscard]] auto Image::get_pixel(const size_t x,
                                     const size_t y) const -> glm::dvec4 {
@@ -50,14 +120,148 @@ auto Image::set_depth(const size_t x, const size_t y,
     auto min_double = std::numeric_limits<double>::min();
     return {min_double, min_double, min_double, min_double};
   }
-  return rgba8_to_dvec4(m_color_buffer[x + y * m_width]);
+  if (m_tiles_cleared[tile_index(x, y)]) {
+    return rgba8_to_dvec4(m_clear_color);
+  }
+  return rgba8_to_dvec4(p_color[x + y * m_width]);
 }
-[[nodiscard]] auto Image::get_depth(const size_t x,
-                                    const size_t y) const -> double {
-  if (x >= m_width || y >= m_height) {
-    return std::numeric_limits<double>::min();
+
+[[nodiscard]] auto Image::get_depth_tiles_x() const -> size_t { return m_depth_tiles_x; }
+[[nodiscard]] auto Image::get_depth_tiles_y() const -> size_t { return m_depth_tiles_y; }
+[[nodiscard]] auto Image::get_depth_tile(const size_t tile_x, const size_t tile_y) -> DepthTile {
+  const auto index = tile_x + tile_y * m_depth_tiles_x;
+  if (m_depth_tiles_dirty[index] && m_tiles_cleared[tile_index(tile_x * depth_tile_size, tile_y * depth_tile_size)]) {
+    m_depth_tiles[index] = {m_clear_depth, m_clear_depth};
+    m_depth_tiles_dirty[index] = 0;
+  } else if (m_depth_tiles_dirty[index]) {
+    const auto max_x = std::min((tile_x + 1) * depth_tile_size, m_width);
+    const auto max_y = std::min((tile_y + 1) * depth_tile_size, m_height);
+    const auto first = load_depth(tile_x * depth_tile_size + tile_y * depth_tile_size * m_width);
+    DepthTile tile{first, first};
+    for (auto y = tile_y * depth_tile_size; y < max_y; ++y) {
+      for (auto x = tile_x * depth_tile_size; x < max_x; ++x) {
+        const auto depth = load_depth(x + y * m_width);
+        tile.min = std::min(tile.min, depth);
+        tile.max = std::max(tile.max, depth);
+      }
+    }
+    m_depth_tiles[index] = tile;
+    m_depth_tiles_dirty[index] = 0;
+  }
+  return m_depth_tiles[index];
+}
+auto Image::invalidate_depth_tiles(const size_t min_x, const size_t min_y,
+                                   const size_t max_x, const size_t max_y) -> void {
+  if (m_depth_tiles_dirty.empty()) {
+    return;
+  }
+  const auto max_tile_x = std::min(max_x / depth_tile_size, m_depth_tiles_x - 1);
+  const auto max_tile_y = std::min(max_y / depth_tile_size, m_depth_tiles_y - 1);
+  for (auto tile_y = min_y / depth_tile_size; tile_y <= max_tile_y; ++tile_y) {
+    for (auto tile_x = min_x / depth_tile_size; tile_x <= max_tile_x; ++tile_x) {
+      m_depth_tiles_dirty[tile_x + tile_y * m_depth_tiles_x] = 1;
+    }
+  }
+}
+
+auto Image::set_hiz_enabled(const bool enabled) -> void { m_hiz_enabled = enabled; }
+[[nodiscard]] auto Image::get_hiz_enabled() const -> bool { return m_hiz_enabled; }
+[[nodiscard]] auto Image::get_hiz_stats() const -> HiZStats { return m_hiz_stats; }
+auto Image::add_hiz_stats(const HiZStats &stats) -> void {
+  const auto add = [](size_t &counter, const size_t value) {
+    if (value != 0) {
+      std::atomic_ref<size_t>{counter}.fetch_add(value, std::memory_order_relaxed);
+    }
+  };
+  add(m_hiz_stats.triangles_tested, stats.triangles_tested);
+  add(m_hiz_stats.triangles_rejected, stats.triangles_rejected);
+  add(m_hiz_stats.spans_rejected, stats.spans_rejected);
+  add(m_hiz_stats.pixels_rejected, stats.pixels_rejected);
+}
+auto Image::reset_hiz_stats() -> void { m_hiz_stats = {}; }
+
+auto Image::resolve_tile(const size_t tile_x, const size_t tile_y) -> void {
+  m_tiles_cleared[tile_x + tile_y * m_tiles_x] = 0;
+  fill_cleared(tile_x * tile_size, std::min((tile_x + 1) * tile_size, m_width), tile_y);
+}
+
+auto Image::fill_cleared(const size_t min_x, const size_t max_x, const size_t tile_y) -> void {
+  const auto min_y = tile_y * tile_size;
+  const auto max_y = std::min(min_y + tile_size, m_height);
+  // Full width spans are contiguous, so the whole tile row is a single fill.
+  const auto rows = max_x - min_x == m_width ? size_t{1} : max_y - min_y;
+  const auto count = static_cast<std::ptrdiff_t>(max_x - min_x == m_width ? m_width * (max_y - min_y) : max_x - min_x);
+  const auto fill = [&](auto *buffer, const auto value) {
+    for (size_t row = 0; row < rows; ++row) {
+      std::fill_n(buffer + min_x + (min_y + row) * m_width, count, value);
+    }
+  };
+  fill(p_color, m_clear_color);
+  switch (m_depth_format) {
+  case DepthFormat::Native: {
+    fill(m_depth_buffer.data(), m_clear_depth);
+  } break;
+  case DepthFormat::D16: {
+    fill(m_depth_buffer_16.data(), encode_d16(m_clear_depth));
+  } break;
+  case DepthFormat::D24: {
+    fill(m_depth_buffer_32.data(), encode_d24(m_clear_depth));
+  } break;
+  case DepthFormat::D32F: {
+    fill(m_depth_buffer_32.data(), encode_d32f(m_clear_depth));
+  } break;
+  }
+}
+
+auto Image::set_color_target(ColorRGBA8 *color_target) -> void {
+  p_color_target = color_target;
+  resize_color_buffer();
+  m_color_buffer.shrink_to_fit();
+}
+
+auto Image::resize_color_buffer() -> void {
+  m_color_buffer.resize(p_color_target ? 0 : m_width * m_height);
+  p_color = p_color_target ? p_color_target : m_color_buffer.data();
+}
+
+auto Image::resize_depth_buffer() -> void {
+  const auto size = m_width * m_height;
+  const auto packed_32 = m_depth_format == DepthFormat::D24 || m_depth_format == DepthFormat::D32F;
+  m_depth_buffer.resize(m_depth_format == DepthFormat::Native ? size : 0);
+  m_depth_buffer_16.resize(m_depth_format == DepthFormat::D16 ? size : 0);
+  m_depth_buffer_32.resize(packed_32 ? size : 0);
+}
+
+auto Image::resize_tiles() -> void {
+  m_tiles_x = (m_width + tile_size - 1) / tile_size;
+  m_tiles_y = (m_height + tile_size - 1) / tile_size;
+  m_tiles_cleared.assign(m_tiles_x * m_tiles_y, 0);
+}
+
+auto Image::resize_depth_tiles() -> void {
+  m_depth_tiles_x = (m_width + depth_tile_size - 1) / depth_tile_size;
+  m_depth_tiles_y = (m_height + depth_tile_size - 1) / depth_tile_size;
+  m_depth_tiles.assign(m_depth_tiles_x * m_depth_tiles_y, DepthTile{});
+  m_depth_tiles_dirty.assign(m_depth_tiles_x * m_depth_tiles_y, 1);
+}
+
+auto Image::save(const std::string &path) const -> void {
+  std::ofstream color_file(path + ".ppm", std::ios::binary);
+  std::ofstream depth_file(path + ".depth", std::ios::binary);
+  if (!color_file || !depth_file) {
+    throw std::runtime_error("Cannot write image \"" + path + "\"!");
+  }
+  color_file << "P6\n" << m_width << ' ' << m_height << "\n255\n";
+  for (size_t i = 0; i < m_width * m_height; ++i) {
+    const auto &pixel = m_tiles_cleared[tile_index(i % m_width, i / m_width)] ? m_clear_color : p_color[i];
+    const char rgb[3] = {static_cast<char>(pixel.r), static_cast<char>(pixel.g), static_cast<char>(pixel.b)};
+    color_file.write(rgb, sizeof(rgb));
+  }
+  depth_file << "VISDEPTH\n" << m_width << ' ' << m_height << '\n';
+  for (size_t i = 0; i < m_width * m_height; ++i) {
+    const auto depth = static_cast<double>(get_depth(i % m_width, i / m_width));
+    depth_file.write(reinterpret_cast<const char *>(&depth), sizeof(depth));
   }
-  return m_depth_buffer[x + y * m_width];
 }
 
 auto Image::dvec4_to_rgba8(const glm::dvec4 &color) const -> ColorRGBA8 {
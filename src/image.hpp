@@ -1,8 +1,14 @@
 #pragma once
 
+#include "vertex.hpp"
+
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <limits>
+#include <string>
 #include <vector>
 
 namespace Vis {
@@ -14,29 +20,161 @@ struct ColorRGBA8 {
   uint8_t a{255};
 };
 
+// Storage of the depth buffer. Native keeps Real precision and is the only
+// format the quad shaders can write through get_depth_data; D16 and D24 are
+// unsigned normalized, D32F is a single precision float.
+enum class DepthFormat { Native, D16, D24, D32F };
+
+// Depth range of one depth_tile_size square of the depth buffer.
+struct DepthTile {
+  Real min{1};
+  Real max{1};
+};
+
+// Work skipped by the hierarchical depth test since the last reset_hiz_stats.
+struct HiZStats {
+  size_t triangles_tested{0};
+  size_t triangles_rejected{0};
+  size_t spans_rejected{0};
+  size_t pixels_rejected{0};
+};
+
 class Image {
 public:
+  static constexpr size_t tile_size{64};
+  static constexpr size_t depth_tile_size{8};
+
   Image();
   Image(const size_t width, const size_t height);
   ~Image() = default;
+  // p_color may point into m_color_buffer, which a move keeps but a copy would not.
+  Image(const Image &) = delete;
+  auto operator=(const Image &) -> Image & = delete;
+  Image(Image &&) = default;
+  auto operator=(Image &&) -> Image & = default;
 
   auto resize(const size_t width, const size_t height) -> void;
 
+  // Fast clear: only marks every tile_size tile as cleared. A tile is filled
+  // with the clear values on its first write or by resolve.
   auto clear(const glm::dvec4 &color = {0.0, 0.0, 0.0, 1.0},
-             const double depth = 1.0) -> void;
+             const Real depth = 1.0) -> void;
+  // Fills every tile still marked as cleared, or those under the inclusive
+  // pixel box. Needed before the raw buffers are read or written directly.
+  auto resolve() -> void;
+  auto resolve(const size_t min_x, const size_t min_y, const size_t max_x,
+               const size_t max_y) -> void;
 
   auto set_pixel(const size_t x, const size_t y,
                  const glm::dvec4 &color) -> void;
-  auto set_depth(const size_t x, const size_t y, const double depth) -> void;
+  auto set_depth(const size_t x, const size_t y, const Real depth) -> void {
+    if (x >= m_width || y >= m_height) {
+      return;
+    }
+    if (m_tiles_cleared[tile_index(x, y)]) {
+      resolve_tile(x / tile_size, y / tile_size);
+    }
+    store_depth(x + y * m_width, depth);
+  }
+  // Renders color into caller owned memory of at least width * height pixels
+  // for every later size, e.g. a mapped pixel buffer; null switches back to
+  // the internal buffer. Contents are undefined until clear. The target is
+  // only written, get_pixel and save need the internal buffer.
+  auto set_color_target(ColorRGBA8 *color_target) -> void;
+  // Reallocates the depth buffer, its contents are undefined until clear.
+  auto set_depth_format(const DepthFormat depth_format) -> void;
 
   [[nodiscard]] auto get_width() const -> size_t;
   [[nodiscard]] auto get_height() const -> size_t;
+  // Raw buffers, cleared tiles hold stale data until resolved.
   [[nodiscard]] auto get_image_data() -> ColorRGBA8 *;
+  // Null unless the depth format is DepthFormat::Native.
+  [[nodiscard]] auto get_depth_data() -> Real *;
+  [[nodiscard]] auto get_depth_format() const -> DepthFormat;
+  [[nodiscard]] auto get_depth_buffer_size() const -> size_t;
   [[nodiscard]] auto get_pixel(const size_t x,
                                const size_t y) const -> glm::dvec4;
-  [[nodiscard]] auto get_depth(const size_t x, const size_t y) const -> double;
+  [[nodiscard]] auto get_depth(const size_t x, const size_t y) const -> Real {
+    if (x >= m_width || y >= m_height) {
+      return std::numeric_limits<Real>::min();
+    }
+    if (m_tiles_cleared[tile_index(x, y)]) {
+      return m_clear_depth;
+    }
+    return load_depth(x + y * m_width);
+  }
+
+  // Hierarchical depth. A tile is rebuilt from the depth buffer on first
+  // access after invalidate_depth_tiles covered it. Depth writes only lower
+  // values, so a stale max is still a safe upper bound for occlusion tests.
+  [[nodiscard]] auto get_depth_tiles_x() const -> size_t;
+  [[nodiscard]] auto get_depth_tiles_y() const -> size_t;
+  [[nodiscard]] auto get_depth_tile(const size_t tile_x, const size_t tile_y) -> DepthTile;
+  auto invalidate_depth_tiles(const size_t min_x, const size_t min_y,
+                              const size_t max_x, const size_t max_y) -> void;
+  // Whether the rasterizers test against the depth tiles, and what that
+  // skipped. add_hiz_stats may be called from every rasterizer thread.
+  auto set_hiz_enabled(const bool enabled) -> void;
+  [[nodiscard]] auto get_hiz_enabled() const -> bool;
+  [[nodiscard]] auto get_hiz_stats() const -> HiZStats;
+  auto add_hiz_stats(const HiZStats &stats) -> void;
+  auto reset_hiz_stats() -> void;
+
+  // Writes `<path>.ppm` with the color buffer and `<path>.depth` with the
+  // depth buffer as raw doubles, so dumps from float and double builds can be
+  // compared without losing precision.
+  auto save(const std::string &path) const -> void;
 
 private:
+  static constexpr Real d16_max{65535};
+  static constexpr Real d24_max{16777215};
+
+  auto load_depth(const size_t index) const -> Real {
+    switch (m_depth_format) {
+    case DepthFormat::D16: {
+      return static_cast<Real>(m_depth_buffer_16[index]) / d16_max;
+    }
+    case DepthFormat::D24: {
+      return static_cast<Real>(m_depth_buffer_32[index]) / d24_max;
+    }
+    case DepthFormat::D32F: {
+      return static_cast<Real>(std::bit_cast<float>(m_depth_buffer_32[index]));
+    }
+    default: {
+      return m_depth_buffer[index];
+    }
+    }
+  }
+  static auto encode_d16(const Real depth) -> uint16_t { return static_cast<uint16_t>(std::clamp(depth, Real{0}, Real{1}) * d16_max + Real{0.5}); }
+  static auto encode_d24(const Real depth) -> uint32_t { return static_cast<uint32_t>(std::clamp(depth, Real{0}, Real{1}) * d24_max + Real{0.5}); }
+  static auto encode_d32f(const Real depth) -> uint32_t { return std::bit_cast<uint32_t>(static_cast<float>(depth)); }
+  auto store_depth(const size_t index, const Real depth) -> void {
+    switch (m_depth_format) {
+    case DepthFormat::D16: {
+      m_depth_buffer_16[index] = encode_d16(depth);
+    } break;
+    case DepthFormat::D24: {
+      m_depth_buffer_32[index] = encode_d24(depth);
+    } break;
+    case DepthFormat::D32F: {
+      m_depth_buffer_32[index] = encode_d32f(depth);
+    } break;
+    default: {
+      m_depth_buffer[index] = depth;
+    } break;
+    }
+  }
+  auto tile_index(const size_t x, const size_t y) const -> size_t {
+    return x / tile_size + (y / tile_size) * m_tiles_x;
+  }
+  auto resolve_tile(const size_t tile_x, const size_t tile_y) -> void;
+  // Writes the clear values to columns [min_x, max_x) of one tile row.
+  auto fill_cleared(const size_t min_x, const size_t max_x, const size_t tile_y) -> void;
+  auto resize_color_buffer() -> void;
+  auto resize_depth_buffer() -> void;
+  auto resize_depth_tiles() -> void;
+  auto resize_tiles() -> void;
+
   auto dvec4_to_rgba8(const glm::dvec4 &color) const -> ColorRGBA8;
 
   auto rgba8_to_dvec4(const ColorRGBA8 &color) const -> glm::dvec4;
@@ -45,7 +183,26 @@ private:
   size_t m_width{0};
   size_t m_height{0};
   std::vector<ColorRGBA8> m_color_buffer;
-  std::vector<double> m_depth_buffer;
+  ColorRGBA8 *p_color_target{nullptr};
+  // Either the internal buffer or p_color_target.
+  ColorRGBA8 *p_color{nullptr};
+  size_t m_tiles_x{0};
+  size_t m_tiles_y{0};
+  std::vector<uint8_t> m_tiles_cleared;
+  ColorRGBA8 m_clear_color{};
+  // Clear depth as get_depth returns it, after the round trip through the depth format.
+  Real m_clear_depth{1};
+  DepthFormat m_depth_format{DepthFormat::Native};
+  std::vector<Real> m_depth_buffer;
+  std::vector<uint16_t> m_depth_buffer_16;
+  // D24 in the low bits or the bit pattern of a D32F float.
+  std::vector<uint32_t> m_depth_buffer_32;
+  size_t m_depth_tiles_x{0};
+  size_t m_depth_tiles_y{0};
+  std::vector<DepthTile> m_depth_tiles;
+  std::vector<uint8_t> m_depth_tiles_dirty;
+  bool m_hiz_enabled{true};
+  HiZStats m_hiz_stats{};
 };
 
 } // namespace Vis
@@ -0,0 +1,112 @@
+#include "index_buffer.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace Vis {
+
+IndexBuffer::IndexBuffer(const IndexFormat index_format) : m_index_format{index_format} {}
+
+IndexBuffer::IndexBuffer(std::initializer_list<size_t> indices)
+    : m_index_format{format_for(indices.size() == 0 ? 0 : std::max(indices) + 1)} {
+  append(indices);
+}
+
+IndexBuffer::IndexBuffer(std::span<const size_t> indices, const size_t vertex_count)
+    : m_index_format{format_for(vertex_count)} {
+  append(indices);
+}
+
+auto IndexBuffer::format_for(const size_t vertex_count) -> IndexFormat {
+  return vertex_count <= size_t{std::numeric_limits<uint16_t>::max()} + 1 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+}
+
+auto IndexBuffer::reserve(const size_t size) -> void {
+  own();
+  if (m_index_format == IndexFormat::UInt16) {
+    m_indices_16.reserve(size);
+  } else {
+    m_indices_32.reserve(size);
+  }
+}
+
+template <typename Index> auto IndexBuffer::append_indices(std::span<const Index> indices) -> void {
+  own();
+  if (indices.empty()) {
+    return;
+  }
+  const auto max_index = *std::max_element(indices.begin(), indices.end());
+  if (max_index > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Index " + std::to_string(max_index) + " does not fit 32 bits!");
+  }
+  if (m_index_format == IndexFormat::UInt16 && max_index > std::numeric_limits<uint16_t>::max()) {
+    widen();
+  }
+  if (m_index_format == IndexFormat::UInt16) {
+    m_indices_16.reserve(m_indices_16.size() + indices.size());
+    std::transform(indices.begin(), indices.end(), std::back_inserter(m_indices_16), [](const Index index) { return static_cast<uint16_t>(index); });
+  } else {
+    m_indices_32.reserve(m_indices_32.size() + indices.size());
+    std::transform(indices.begin(), indices.end(), std::back_inserter(m_indices_32), [](const Index index) { return static_cast<uint32_t>(index); });
+  }
+}
+
+auto IndexBuffer::append(std::span<const size_t> indices) -> void { append_indices(indices); }
+
+auto IndexBuffer::append(std::span<const uint32_t> indices) -> void { append_indices(indices); }
+
+auto IndexBuffer::push_back(const size_t index) -> void {
+  append({&index, 1});
+}
+
+auto IndexBuffer::set(const size_t position, const size_t index) -> void {
+  own();
+  if (index > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Index " + std::to_string(index) + " does not fit 32 bits!");
+  }
+  if (m_index_format == IndexFormat::UInt16 && index > std::numeric_limits<uint16_t>::max()) {
+    widen();
+  }
+  if (m_index_format == IndexFormat::UInt16) {
+    m_indices_16.at(position) = static_cast<uint16_t>(index);
+  } else {
+    m_indices_32.at(position) = static_cast<uint32_t>(index);
+  }
+}
+
+auto IndexBuffer::set_mapped(std::span<const uint32_t> indices) -> void {
+  m_index_format = IndexFormat::UInt32;
+  m_indices_16.clear();
+  m_indices_32.clear();
+  m_mapped = indices;
+}
+
+auto IndexBuffer::size() const -> size_t {
+  return m_index_format == IndexFormat::UInt16 ? m_indices_16.size() : get_indices<uint32_t>().size();
+}
+
+auto IndexBuffer::empty() const -> bool { return size() == 0; }
+
+auto IndexBuffer::get_format() const -> IndexFormat { return m_index_format; }
+
+auto IndexBuffer::get_size_bytes() const -> size_t {
+  return m_index_format == IndexFormat::UInt16 ? m_indices_16.size() * sizeof(uint16_t) : get_indices<uint32_t>().size_bytes();
+}
+
+auto IndexBuffer::widen() -> void {
+  m_indices_32.assign(m_indices_16.begin(), m_indices_16.end());
+  m_indices_16 = {};
+  m_index_format = IndexFormat::UInt32;
+}
+
+auto IndexBuffer::own() -> void {
+  if (!m_mapped.empty()) {
+    m_indices_32.assign(m_mapped.begin(), m_mapped.end());
+    m_mapped = {};
+  }
+}
+
+} // namespace Vis
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace Vis {
+
+enum class IndexFormat { UInt16, UInt32 };
+
+// Indices of a Solid in the narrowest format that holds every index, 16 bit
+// below 65536 vertices and 32 bit above. Adding a larger index widens the
+// buffer once.
+class IndexBuffer {
+public:
+  IndexBuffer() = default;
+  explicit IndexBuffer(const IndexFormat index_format);
+  IndexBuffer(std::initializer_list<size_t> indices);
+  IndexBuffer(std::span<const size_t> indices, const size_t vertex_count);
+
+  [[nodiscard]] static auto format_for(const size_t vertex_count) -> IndexFormat;
+
+  auto reserve(const size_t size) -> void;
+  auto append(std::span<const size_t> indices) -> void;
+  auto append(std::span<const uint32_t> indices) -> void;
+  auto push_back(const size_t index) -> void;
+  auto set(const size_t position, const size_t index) -> void;
+  // Uses 32 bit indices owned elsewhere, e.g. by a mapped file, in place.
+  // Any later modification copies them first.
+  auto set_mapped(std::span<const uint32_t> indices) -> void;
+
+  [[nodiscard]] auto get(const size_t position) const -> size_t {
+    if (m_index_format == IndexFormat::UInt16) {
+      return m_indices_16[position];
+    }
+    return m_mapped.empty() ? m_indices_32[position] : m_mapped[position];
+  }
+  [[nodiscard]] auto size() const -> size_t;
+  [[nodiscard]] auto empty() const -> bool;
+  [[nodiscard]] auto get_format() const -> IndexFormat;
+  [[nodiscard]] auto get_size_bytes() const -> size_t;
+  // Index must be the type of the current format.
+  template <typename Index> [[nodiscard]] auto get_indices() const -> std::span<const Index> {
+    if constexpr (std::is_same_v<Index, uint16_t>) {
+      return m_indices_16;
+    } else {
+      static_assert(std::is_same_v<Index, uint32_t>);
+      return m_mapped.empty() ? std::span<const uint32_t>{m_indices_32} : m_mapped;
+    }
+  }
+
+private:
+  template <typename Index> auto append_indices(std::span<const Index> indices) -> void;
+  auto widen() -> void;
+  auto own() -> void;
+
+private:
+  IndexFormat m_index_format{IndexFormat::UInt16};
+  std::vector<uint16_t> m_indices_16{};
+  std::vector<uint32_t> m_indices_32{};
+  // Used instead of m_indices_32 while not empty.
+  std::span<const uint32_t> m_mapped{};
+};
+
+} // namespace Vis
@@ -0,0 +1,102 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vis {
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string &path) {
+  p_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (p_file == INVALID_HANDLE_VALUE) {
+    p_file = nullptr;
+    throw std::runtime_error("Failed to open " + path);
+  }
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(p_file, &size)) {
+    CloseHandle(p_file);
+    throw std::runtime_error("Failed to get size of " + path);
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+  if (m_size == 0) {
+    return;
+  }
+  p_mapping = CreateFileMappingA(p_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!p_mapping) {
+    CloseHandle(p_file);
+    throw std::runtime_error("Failed to map " + path);
+  }
+  p_data = static_cast<const char *>(MapViewOfFile(p_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!p_data) {
+    CloseHandle(p_mapping);
+    CloseHandle(p_file);
+    throw std::runtime_error("Failed to map " + path);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (p_data) {
+    UnmapViewOfFile(p_data);
+  }
+  if (p_mapping) {
+    CloseHandle(p_mapping);
+  }
+  if (p_file) {
+    CloseHandle(p_file);
+  }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) {
+  m_file = open(path.c_str(), O_RDONLY);
+  if (m_file < 0) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  struct stat info {};
+  if (fstat(m_file, &info) != 0) {
+    close(m_file);
+    throw std::runtime_error("Failed to get size of " + path);
+  }
+  m_size = static_cast<size_t>(info.st_size);
+  if (m_size == 0) {
+    return;
+  }
+  void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+  if (data == MAP_FAILED) {
+    close(m_file);
+    throw std::runtime_error("Failed to map " + path);
+  }
+  // Parsers read the file front to back exactly once.
+  madvise(data, m_size, MADV_SEQUENTIAL);
+  madvise(data, m_size, MADV_WILLNEED);
+  p_data = static_cast<const char *>(data);
+}
+
+MappedFile::~MappedFile() {
+  if (p_data) {
+    munmap(const_cast<char *>(p_data), m_size);
+  }
+  if (m_file >= 0) {
+    close(m_file);
+  }
+}
+
+#endif
+
+auto MappedFile::get_data() const -> const char * { return p_data; }
+
+auto MappedFile::get_size() const -> size_t { return m_size; }
+
+} // namespace Vis
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Vis {
+
+// Read only memory mapping of a whole file. An empty file maps to a null
+// pointer with size 0.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  auto operator=(const MappedFile &) -> MappedFile & = delete;
+
+  [[nodiscard]] auto get_data() const -> const char *;
+  [[nodiscard]] auto get_size() const -> size_t;
+
+private:
+  const char *p_data{nullptr};
+  size_t m_size{0};
+#if defined(_WIN32)
+  void *p_file{nullptr};
+  void *p_mapping{nullptr};
+#else
+  int m_file{-1};
+#endif
+};
+
+} // namespace Vis
@@ -0,0 +1,719 @@
+#include "mesh_loader.hpp"
+
+#include "mapped_file.hpp"
+#include "solid_file.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace Vis {
+
+namespace {
+
+constexpr size_t no_index{std::numeric_limits<size_t>::max()};
+
+// Indices of every topology, concatenated into the Solid once parsing is done.
+struct Primitives {
+  std::vector<size_t> triangles{};
+  std::vector<size_t> lines{};
+  std::vector<size_t> points{};
+};
+
+auto finish_solid(Solid &solid, Primitives &primitives) -> void {
+  if (primitives.triangles.empty() && primitives.lines.empty() && primitives.points.empty()) {
+    primitives.points.resize(solid.vertices.size());
+    for (size_t i = 0; i < primitives.points.size(); ++i) {
+      primitives.points[i] = i;
+    }
+  }
+  solid.indices = IndexBuffer{IndexBuffer::format_for(solid.vertices.size())};
+  solid.indices.reserve(primitives.triangles.size() + primitives.lines.size() + primitives.points.size());
+  if (!primitives.triangles.empty()) {
+    solid.layout.push_back({Topology::Triangle, solid.indices.size(), primitives.triangles.size() / 3});
+    solid.indices.append(primitives.triangles);
+  }
+  if (!primitives.lines.empty()) {
+    solid.layout.push_back({Topology::Line, solid.indices.size(), primitives.lines.size() / 2});
+    solid.indices.append(primitives.lines);
+  }
+  if (!primitives.points.empty()) {
+    solid.layout.push_back({Topology::Point, solid.indices.size(), primitives.points.size()});
+    solid.indices.append(primitives.points);
+  }
+}
+
+auto fit_matrix(const std::vector<Vertex> &vertices) -> glm::dmat4 {
+  if (vertices.empty()) {
+    return glm::dmat4{1.0};
+  }
+  glm::dvec3 min{vertices.front().pos};
+  glm::dvec3 max{min};
+  for (const auto &vertex : vertices) {
+    min = glm::min(min, glm::dvec3{vertex.pos});
+    max = glm::max(max, glm::dvec3{vertex.pos});
+  }
+  const auto center = (min + max) * 0.5;
+  const auto half_size = (max - min) * 0.5;
+  const auto extent = std::max({half_size.x, half_size.y, half_size.z});
+  const auto scale = extent > 0.0 ? 1.0 / extent : 1.0;
+  glm::dmat4 matrix{scale};
+  matrix[3] = glm::dvec4{-center * scale, 1.0};
+  return matrix;
+}
+
+// Text cursor over a mapped file, errors carry the line number.
+struct Cursor {
+  const char *p;
+  const char *end;
+  const std::string &path;
+  size_t line{1};
+
+  [[noreturn]] auto fail(const std::string_view what) const -> void {
+    throw std::runtime_error(path + ':' + std::to_string(line) + ": " + std::string{what});
+  }
+  auto skip_blank() -> void {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+      ++p;
+    }
+  }
+  [[nodiscard]] auto at_line_end() const -> bool { return p == end || *p == '\n' || *p == '#'; }
+  auto skip_line() -> void {
+    const auto *newline = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    p = newline ? newline + 1 : end;
+    ++line;
+  }
+  [[nodiscard]] auto parse_real(Real &value) -> bool {
+    skip_blank();
+    if (at_line_end()) {
+      return false;
+    }
+    if (*p == '+') {
+      ++p;
+    }
+    const auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc{}) {
+      fail("invalid number");
+    }
+    p = ptr;
+    return true;
+  }
+  // Resolves a one based or negative relative OBJ index against count elements.
+  [[nodiscard]] auto parse_index(const size_t count) -> size_t {
+    long long value{0};
+    const auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc{} || value == 0) {
+      fail("invalid index");
+    }
+    p = ptr;
+    const auto index = value > 0 ? static_cast<size_t>(value - 1) : count - static_cast<size_t>(-value);
+    if (index >= count) {
+      fail("index out of range");
+    }
+    return index;
+  }
+};
+
+class ObjParser {
+public:
+  ObjParser(const char *begin, const char *end, const std::string &path) : m_cursor{begin, end, path} {}
+
+  auto parse(Solid &solid, Primitives &primitives) -> void {
+    auto &c = m_cursor;
+    while (c.p < c.end) {
+      c.skip_blank();
+      if (c.p + 1 >= c.end) {
+        break;
+      }
+      const auto blank_after = [&](const size_t offset) { return c.p + offset < c.end && (c.p[offset] == ' ' || c.p[offset] == '\t'); };
+      if (c.p[0] == 'v' && blank_after(1)) {
+        c.p += 1;
+        parse_position();
+      } else if (c.p[0] == 'v' && c.p[1] == 't' && blank_after(2)) {
+        c.p += 2;
+        Vec2 tex{0.0, 0.0};
+        if (!c.parse_real(tex.x)) {
+          c.fail("texture coordinate needs at least one component");
+        }
+        static_cast<void>(c.parse_real(tex.y));
+        m_texcoords.push_back(tex);
+      } else if (c.p[0] == 'v' && c.p[1] == 'n' && blank_after(2)) {
+        c.p += 2;
+        Vec3 normal{};
+        if (!c.parse_real(normal.x) || !c.parse_real(normal.y) || !c.parse_real(normal.z)) {
+          c.fail("normal needs three components");
+        }
+        m_normals.push_back(normal);
+      } else if ((c.p[0] == 'f' || c.p[0] == 'l' || c.p[0] == 'p') && blank_after(1)) {
+        const auto kind = c.p[0];
+        c.p += 1;
+        parse_polygon(solid);
+        if (kind == 'f') {
+          if (m_polygon.size() < 3) {
+            c.fail("face needs at least three vertices");
+          }
+          for (size_t i = 1; i + 1 < m_polygon.size(); ++i) {
+            primitives.triangles.insert(primitives.triangles.end(), {m_polygon[0], m_polygon[i], m_polygon[i + 1]});
+          }
+        } else if (kind == 'l') {
+          if (m_polygon.size() < 2) {
+            c.fail("line needs at least two vertices");
+          }
+          for (size_t i = 0; i + 1 < m_polygon.size(); ++i) {
+            primitives.lines.insert(primitives.lines.end(), {m_polygon[i], m_polygon[i + 1]});
+          }
+        } else {
+          primitives.points.insert(primitives.points.end(), m_polygon.begin(), m_polygon.end());
+        }
+      }
+      c.skip_line();
+    }
+    if (primitives.triangles.empty() && primitives.lines.empty() && primitives.points.empty()) {
+      for (size_t i = 0; i < m_positions.size(); ++i) {
+        primitives.points.push_back(vertex_index(solid, i, no_index, no_index));
+      }
+    }
+  }
+
+private:
+  // Texture coordinate and normal of a vertex and the next vertex sharing its position.
+  struct Corner {
+    size_t tex;
+    size_t normal;
+    size_t next;
+  };
+
+  // `v x y z [w]` or the common `v x y z r g b` vertex color extension.
+  auto parse_position() -> void {
+    std::array<Real, 7> values{};
+    size_t count{0};
+    while (count < values.size() && m_cursor.parse_real(values[count])) {
+      ++count;
+    }
+    if (count < 3) {
+      m_cursor.fail("position needs three components");
+    }
+    m_positions.push_back({values[0], values[1], values[2]});
+    if (count >= 6) {
+      m_colors.resize(m_positions.size(), Vec3{1.0, 1.0, 1.0});
+      m_colors.back() = {values[3], values[4], values[5]};
+    }
+  }
+
+  // Fills m_polygon with the vertex indices of `v`, `v/t`, `v//n` or `v/t/n` references.
+  auto parse_polygon(Solid &solid) -> void {
+    auto &c = m_cursor;
+    m_polygon.clear();
+    while (true) {
+      c.skip_blank();
+      if (c.at_line_end()) {
+        break;
+      }
+      const auto position = c.parse_index(m_positions.size());
+      size_t tex{no_index};
+      size_t normal{no_index};
+      if (c.p < c.end && *c.p == '/') {
+        ++c.p;
+        if (c.p < c.end && *c.p != '/') {
+          tex = c.parse_index(m_texcoords.size());
+        }
+        if (c.p < c.end && *c.p == '/') {
+          ++c.p;
+          normal = c.parse_index(m_normals.size());
+        }
+      }
+      if (c.p < c.end && *c.p != ' ' && *c.p != '\t' && *c.p != '\r' && *c.p != '\n') {
+        c.fail("invalid vertex reference");
+      }
+      m_polygon.push_back(vertex_index(solid, position, tex, normal));
+    }
+  }
+
+  auto vertex_index(Solid &solid, const size_t position, const size_t tex, const size_t normal) -> size_t {
+    if (m_first.size() < m_positions.size()) {
+      m_first.resize(m_positions.size(), no_index);
+    }
+    for (size_t i = m_first[position]; i != no_index; i = m_corners[i].next) {
+      if (m_corners[i].tex == tex && m_corners[i].normal == normal) {
+        return i;
+      }
+    }
+    const auto index = solid.vertices.size();
+    m_corners.push_back({tex, normal, m_first[position]});
+    m_first[position] = index;
+    Vertex vertex{Vec4{m_positions[position], 1.0}};
+    if (position < m_colors.size()) {
+      vertex.col = Vec4{m_colors[position], 1.0};
+    } else if (normal != no_index) {
+      vertex.col = Vec4{m_normals[normal] * Real{0.5} + Real{0.5}, 1.0};
+    }
+    if (tex != no_index) {
+      vertex.tex = m_texcoords[tex];
+    }
+    solid.vertices.push_back(vertex);
+    return index;
+  }
+
+private:
+  Cursor m_cursor;
+  std::vector<Vec3> m_positions{};
+  // Only as long as the last position with a color.
+  std::vector<Vec3> m_colors{};
+  std::vector<Vec2> m_texcoords{};
+  std::vector<Vec3> m_normals{};
+  // First vertex of every position, chained through m_corners.
+  std::vector<size_t> m_first{};
+  std::vector<Corner> m_corners{};
+  std::vector<size_t> m_polygon{};
+};
+
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PlyProperty {
+  std::string name{};
+  PlyType type{PlyType::Float32};
+  bool list{false};
+  PlyType count_type{PlyType::UInt8};
+};
+
+struct PlyElement {
+  std::string name{};
+  size_t count{0};
+  std::vector<PlyProperty> properties{};
+};
+
+auto ply_type(const std::string_view name) -> PlyType {
+  if (name == "char" || name == "int8") {
+    return PlyType::Int8;
+  } else if (name == "uchar" || name == "uint8") {
+    return PlyType::UInt8;
+  } else if (name == "short" || name == "int16") {
+    return PlyType::Int16;
+  } else if (name == "ushort" || name == "uint16") {
+    return PlyType::UInt16;
+  } else if (name == "int" || name == "int32") {
+    return PlyType::Int32;
+  } else if (name == "uint" || name == "uint32") {
+    return PlyType::UInt32;
+  } else if (name == "float" || name == "float32") {
+    return PlyType::Float32;
+  } else if (name == "double" || name == "float64") {
+    return PlyType::Float64;
+  }
+  throw std::runtime_error("Unknown PLY property type " + std::string{name});
+}
+
+auto ply_size(const PlyType type) -> size_t {
+  switch (type) {
+  case PlyType::Int8:
+  case PlyType::UInt8: {
+    return 1;
+  }
+  case PlyType::Int16:
+  case PlyType::UInt16: {
+    return 2;
+  }
+  case PlyType::Float64: {
+    return 8;
+  }
+  default: {
+    return 4;
+  }
+  }
+}
+
+// Integer colors are normalized by the maximum of their type.
+auto ply_color_scale(const PlyType type) -> double {
+  switch (type) {
+  case PlyType::UInt8: {
+    return 1.0 / 255.0;
+  }
+  case PlyType::UInt16: {
+    return 1.0 / 65535.0;
+  }
+  default: {
+    return 1.0;
+  }
+  }
+}
+
+template <typename T> auto ply_load(const char *p, const bool big_endian) -> T {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  if constexpr (sizeof(T) > 1) {
+    if (big_endian != (std::endian::native == std::endian::big)) {
+      using Bits = std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+      value = std::bit_cast<T>(std::byteswap(std::bit_cast<Bits>(value)));
+    }
+  }
+  return value;
+}
+
+class PlyParser {
+public:
+  PlyParser(const char *begin, const char *end, const std::string &path) : m_cursor{begin, end, path} {}
+
+  auto parse(Solid &solid, Primitives &primitives) -> void {
+    parse_header();
+    for (const auto &element : m_elements) {
+      // Checked before anything is reserved, so a corrupt count cannot
+      // allocate more than the file can hold.
+      const auto record_size = min_record_size(element);
+      if (record_size != 0 && element.count > remaining() / record_size) {
+        m_cursor.fail("element " + element.name + " has more records than the file holds");
+      }
+      if (element.name == "vertex") {
+        parse_vertices(element, solid);
+      } else if (element.name == "face") {
+        parse_faces(element, primitives);
+      } else if (element.name == "edge") {
+        parse_edges(element, primitives);
+      } else if (record_size != 0) {
+        for (size_t i = 0; i < element.count; ++i) {
+          for (const auto &property : element.properties) {
+            static_cast<void>(read(property));
+          }
+        }
+      }
+    }
+    const auto vertex_count = solid.vertices.size();
+    for (const auto *indices : {&primitives.triangles, &primitives.lines}) {
+      if (std::any_of(indices->begin(), indices->end(), [&](const size_t index) { return index >= vertex_count; })) {
+        m_cursor.fail("vertex index out of range");
+      }
+    }
+  }
+
+private:
+  auto parse_header() -> void {
+    auto &c = m_cursor;
+    const auto next_line = [&]() -> std::string_view {
+      const auto *begin = c.p;
+      c.skip_line();
+      auto line = std::string_view{begin, static_cast<size_t>(c.p - begin)};
+      while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+      }
+      return line;
+    };
+    const auto split = [](std::string_view line) {
+      std::vector<std::string_view> words;
+      while (!line.empty()) {
+        const auto begin = line.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) {
+          break;
+        }
+        line.remove_prefix(begin);
+        const auto size = std::min(line.find_first_of(" \t"), line.size());
+        words.push_back(line.substr(0, size));
+        line.remove_prefix(size);
+      }
+      return words;
+    };
+    if (next_line() != "ply") {
+      c.fail("missing ply magic");
+    }
+    while (true) {
+      if (c.p >= c.end) {
+        c.fail("missing end_header");
+      }
+      const auto words = split(next_line());
+      if (words.empty() || words[0] == "comment" || words[0] == "obj_info") {
+        continue;
+      }
+      if (words[0] == "end_header") {
+        break;
+      }
+      if (words[0] == "format" && words.size() >= 2) {
+        if (words[1] == "binary_little_endian") {
+          m_big_endian = false;
+        } else if (words[1] == "binary_big_endian") {
+          m_big_endian = true;
+        } else {
+          c.fail("only binary PLY files are supported");
+        }
+      } else if (words[0] == "element" && words.size() == 3) {
+        size_t count{0};
+        const auto [ptr, ec] = std::from_chars(words[2].data(), words[2].data() + words[2].size(), count);
+        if (ec != std::errc{}) {
+          c.fail("invalid element count");
+        }
+        m_elements.push_back({std::string{words[1]}, count, {}});
+      } else if (words[0] == "property" && !m_elements.empty()) {
+        PlyProperty property{};
+        if (words.size() == 5 && words[1] == "list") {
+          property = {std::string{words[4]}, ply_type(words[3]), true, ply_type(words[2])};
+        } else if (words.size() == 3) {
+          property = {std::string{words[2]}, ply_type(words[1])};
+        } else {
+          c.fail("invalid property");
+        }
+        m_elements.back().properties.push_back(property);
+      } else {
+        c.fail("invalid header line");
+      }
+    }
+  }
+
+  [[nodiscard]] auto remaining() const -> size_t { return static_cast<size_t>(m_cursor.end - m_cursor.p); }
+
+  // Scalars plus the length of every list, the size of a record with empty lists.
+  [[nodiscard]] static auto min_record_size(const PlyElement &element) -> size_t {
+    size_t size{0};
+    for (const auto &property : element.properties) {
+      size += ply_size(property.list ? property.count_type : property.type);
+    }
+    return size;
+  }
+
+  [[nodiscard]] auto take(const size_t size) -> const char * {
+    if (remaining() < size) {
+      m_cursor.fail("unexpected end of file");
+    }
+    const auto *p = m_cursor.p;
+    m_cursor.p += size;
+    return p;
+  }
+
+  [[nodiscard]] auto read_scalar(const PlyType type) -> double {
+    const auto *p = take(ply_size(type));
+    switch (type) {
+    case PlyType::Int8: {
+      return static_cast<double>(ply_load<int8_t>(p, m_big_endian));
+    }
+    case PlyType::UInt8: {
+      return static_cast<double>(ply_load<uint8_t>(p, m_big_endian));
+    }
+    case PlyType::Int16: {
+      return static_cast<double>(ply_load<int16_t>(p, m_big_endian));
+    }
+    case PlyType::UInt16: {
+      return static_cast<double>(ply_load<uint16_t>(p, m_big_endian));
+    }
+    case PlyType::Int32: {
+      return static_cast<double>(ply_load<int32_t>(p, m_big_endian));
+    }
+    case PlyType::UInt32: {
+      return static_cast<double>(ply_load<uint32_t>(p, m_big_endian));
+    }
+    case PlyType::Float32: {
+      return static_cast<double>(ply_load<float>(p, m_big_endian));
+    }
+    default: {
+      return ply_load<double>(p, m_big_endian);
+    }
+    }
+  }
+
+  // Reads a scalar, or skips a list and returns its length.
+  [[nodiscard]] auto read(const PlyProperty &property) -> double {
+    if (!property.list) {
+      return read_scalar(property.type);
+    }
+    const auto count = read_count(property);
+    static_cast<void>(take(count * ply_size(property.type)));
+    return static_cast<double>(count);
+  }
+
+  // Reads a list length, checked against the bytes left before any list is
+  // resized or skipped.
+  [[nodiscard]] auto read_count(const PlyProperty &property) -> size_t {
+    const auto count = read_scalar(property.count_type);
+    if (count < 0.0) {
+      m_cursor.fail("negative list length");
+    }
+    if (count > static_cast<double>(remaining() / ply_size(property.type))) {
+      m_cursor.fail("list longer than the file");
+    }
+    return static_cast<size_t>(count);
+  }
+
+  auto read_list(const PlyProperty &property) -> void {
+    m_list.resize(read_count(property));
+    for (auto &index : m_list) {
+      const auto value = read_scalar(property.type);
+      if (value < 0.0) {
+        m_cursor.fail("negative vertex index");
+      }
+      index = static_cast<size_t>(value);
+    }
+  }
+
+  auto parse_vertices(const PlyElement &element, Solid &solid) -> void {
+    enum Slot { X, Y, Z, NX, NY, NZ, Red, Green, Blue, Alpha, U, V, None };
+    const auto slot_of = [](const std::string_view name) -> Slot {
+      constexpr std::array<std::pair<std::string_view, Slot>, 18> slots{{
+          {"x", X}, {"y", Y}, {"z", Z}, {"nx", NX}, {"ny", NY}, {"nz", NZ},
+          {"red", Red}, {"green", Green}, {"blue", Blue}, {"alpha", Alpha},
+          {"u", U}, {"v", V}, {"s", U}, {"t", V}, {"texture_u", U}, {"texture_v", V},
+          {"texture_s", U}, {"texture_t", V},
+      }};
+      const auto it = std::find_if(slots.begin(), slots.end(), [&](const auto &slot) { return slot.first == name; });
+      return it == slots.end() ? None : it->second;
+    };
+    std::vector<Slot> property_slots;
+    std::vector<double> property_scales;
+    std::array<bool, None + 1> has_slot{};
+    for (const auto &property : element.properties) {
+      const auto slot = property.list ? None : slot_of(property.name);
+      property_slots.push_back(slot);
+      property_scales.push_back(slot >= Red && slot <= Alpha ? ply_color_scale(property.type) : 1.0);
+      has_slot[slot] = true;
+    }
+    if (!has_slot[X] || !has_slot[Y] || !has_slot[Z]) {
+      m_cursor.fail("vertex element needs x, y and z");
+    }
+    const bool has_normal = has_slot[NX] && has_slot[NY] && has_slot[NZ];
+    const bool has_color = has_slot[Red] && has_slot[Green] && has_slot[Blue];
+    solid.vertices.reserve(solid.vertices.size() + element.count);
+    std::array<double, None + 1> values{};
+    for (size_t i = 0; i < element.count; ++i) {
+      values[Alpha] = 1.0;
+      for (size_t j = 0; j < element.properties.size(); ++j) {
+        values[property_slots[j]] = read(element.properties[j]) * property_scales[j];
+      }
+      Vertex vertex{Vec4{values[X], values[Y], values[Z], 1.0}};
+      if (has_color) {
+        vertex.col = Vec4{values[Red], values[Green], values[Blue], values[Alpha]};
+      } else if (has_normal) {
+        vertex.col = Vec4{Vec3{values[NX], values[NY], values[NZ]} * Real{0.5} + Real{0.5}, 1.0};
+      }
+      vertex.tex = Vec2{values[U], values[V]};
+      solid.vertices.push_back(vertex);
+    }
+  }
+
+  auto parse_faces(const PlyElement &element, Primitives &primitives) -> void {
+    const auto indices = std::find_if(element.properties.begin(), element.properties.end(), [](const PlyProperty &property) {
+      return property.list && (property.name == "vertex_indices" || property.name == "vertex_index");
+    });
+    if (indices == element.properties.end()) {
+      m_cursor.fail("face element needs vertex_indices");
+    }
+    // At most as many faces as records with three indices fit in the file.
+    const auto face_size = min_record_size(element) + 3 * ply_size(indices->type);
+    primitives.triangles.reserve(primitives.triangles.size() + std::min(element.count, remaining() / face_size) * 3);
+    for (size_t i = 0; i < element.count; ++i) {
+      for (auto property = element.properties.begin(); property != element.properties.end(); ++property) {
+        if (property != indices) {
+          static_cast<void>(read(*property));
+          continue;
+        }
+        read_list(*property);
+        if (m_list.size() < 3) {
+          m_cursor.fail("face needs at least three vertices");
+        }
+        for (size_t j = 1; j + 1 < m_list.size(); ++j) {
+          primitives.triangles.insert(primitives.triangles.end(), {m_list[0], m_list[j], m_list[j + 1]});
+        }
+      }
+    }
+  }
+
+  auto parse_edges(const PlyElement &element, Primitives &primitives) -> void {
+    primitives.lines.reserve(primitives.lines.size() + element.count * 2);
+    for (size_t i = 0; i < element.count; ++i) {
+      std::array<double, 2> ends{-1.0, -1.0};
+      for (const auto &property : element.properties) {
+        const auto value = read(property);
+        if (property.name == "vertex1") {
+          ends[0] = value;
+        } else if (property.name == "vertex2") {
+          ends[1] = value;
+        }
+      }
+      if (ends[0] < 0.0 || ends[1] < 0.0) {
+        m_cursor.fail("edge needs vertex1 and vertex2");
+      }
+      primitives.lines.insert(primitives.lines.end(), {static_cast<size_t>(ends[0]), static_cast<size_t>(ends[1])});
+    }
+  }
+
+private:
+  Cursor m_cursor;
+  bool m_big_endian{false};
+  std::vector<PlyElement> m_elements{};
+  std::vector<size_t> m_list{};
+};
+
+} // namespace
+
+auto MeshLoadStats::megabytes_per_second() const -> double {
+  return seconds > 0.0 ? static_cast<double>(bytes) / 1.0e6 / seconds : 0.0;
+}
+
+auto load_mesh(const std::string &path, MeshLoadStats *stats) -> Solid {
+  const auto extension = [&]() {
+    auto result = path.substr(std::min(path.rfind('.'), path.size()));
+    std::transform(result.begin(), result.end(), result.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+  }();
+  if (extension != ".obj" && extension != ".ply" && extension != ".vis") {
+    throw std::runtime_error("Unsupported mesh format " + path + ", expected .obj, .ply or .vis");
+  }
+  double seconds{0.0};
+  Solid solid{};
+  size_t bytes{0};
+  {
+    Timer timer{&seconds};
+    if (extension == ".vis") {
+      solid = load_solid(path);
+    } else {
+      const MappedFile file{path};
+      bytes = file.get_size();
+      const auto *begin = file.get_data();
+      const auto *end = begin + bytes;
+      Primitives primitives{};
+      if (extension == ".obj") {
+        ObjParser{begin, end, path}.parse(solid, primitives);
+      } else {
+        PlyParser{begin, end, path}.parse(solid, primitives);
+      }
+      finish_solid(solid, primitives);
+      if (solid.vertices.empty()) {
+        throw std::runtime_error(path + " contains no vertices");
+      }
+      const auto slash = path.find_last_of("/\\");
+      solid.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+      solid.matrix = fit_matrix(solid.vertices);
+    }
+  }
+  if (stats) {
+    *stats = {bytes, solid.get_vertices().size(), 0, 0, 0, seconds};
+    for (const auto &layout : solid.layout) {
+      switch (layout.topology) {
+      case Topology::Triangle: {
+        stats->triangles += layout.count;
+      } break;
+      case Topology::Line: {
+        stats->lines += layout.count;
+      } break;
+      case Topology::Point: {
+        stats->points += layout.count;
+      } break;
+      }
+    }
+  }
+  return solid;
+}
+
+auto operator<<(std::ostream &out, const MeshLoadStats &stats) -> std::ostream & {
+  out << stats.vertices << " vertices, " << stats.triangles << " triangles, " << stats.lines << " lines, " << stats.points << " points, ";
+  if (stats.bytes == 0) {
+    out << "loaded in " << stats.seconds << " s\n";
+  } else {
+    out << static_cast<double>(stats.bytes) / 1.0e6 << " MB in " << stats.seconds << " s (" << stats.megabytes_per_second() << " MB/s)\n";
+  }
+  return out;
+}
+
+} // namespace Vis
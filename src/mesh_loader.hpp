@@ -0,0 +1,36 @@
+#pragma once
+
+#include "solid.hpp"
+
+#include <ostream>
+#include <string>
+
+namespace Vis {
+
+struct MeshLoadStats {
+  // Bytes parsed, zero for a .vis file: it is mapped lazily and nothing has
+  // been read yet when load_mesh returns.
+  size_t bytes{0};
+  size_t vertices{0};
+  size_t triangles{0};
+  size_t lines{0};
+  size_t points{0};
+  double seconds{0.0};
+
+  // Zero when nothing was parsed.
+  [[nodiscard]] auto megabytes_per_second() const -> double;
+};
+
+// Loads a Wavefront OBJ or a binary PLY file, chosen by the extension, into
+// an indexed Solid with one Layout per topology, or a .vis file through
+// load_solid. The file is memory mapped and parsed in a single pass. OBJ
+// corners sharing position, texture coordinate and normal become one vertex,
+// PLY keeps the indexing of the file. Polygons are fan triangulated and a file
+// without primitives is loaded as points. Vertex colors come from the file,
+// else from the normals, else are white. The matrix fits the mesh into the
+// [-1, 1] cube of the built in solids.
+[[nodiscard]] auto load_mesh(const std::string &path, MeshLoadStats *stats = nullptr) -> Solid;
+
+auto operator<<(std::ostream &out, const MeshLoadStats &stats) -> std::ostream &;
+
+} // namespace Vis
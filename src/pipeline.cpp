@@ -1,5 +1,13 @@
 #include "pipeline.hpp"
+#include "fragment.hpp"
+#include "thread_pool.hpp"
+#include "vertex_cache.hpp"
+#include "vertex_stream.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <limits>
 #define PLANE_TEST(test_plane, value, comparison_operator_in) \
   for (size_t j = 0; j < v_in.size(); ++j) { \
     const auto &v1 = v_in[j]; \
@@ -20,6 +28,661 @@
     } \
   }
 namespace Vis {
+namespace {
+// Convex polygon produced by clipping one triangle; every plane adds at most one vertex.
+struct ClipPolygon {
+  static constexpr size_t capacity{8};
+  std::array<Vertex, capacity> vertices;
+  size_t count{0};
+  ClipPolygon() = default;
+  ClipPolygon(const ClipPolygon &) = delete;
+  auto operator=(const ClipPolygon &polygon) -> ClipPolygon & {
+    std::copy_n(polygon.vertices.begin(), polygon.count, vertices.begin());
+    count = polygon.count;
+    return *this;
+  }
+  auto operator[](const size_t index) const -> const Vertex & { return vertices[index]; }
+  [[nodiscard]] auto size() const -> size_t { return count; }
+  auto clear() -> void { count = 0; }
+  auto push_back(const Vertex &vertex) -> void { vertices[count++] = vertex; }
+};
+// Output buffer for stages that can emit more vertices than they read. It is swapped with the stage's input, so both
+// buffers keep their capacity and a steady-state frame does not allocate.
+auto clip_scratch() -> std::vector<Vertex> & {
+  thread_local std::vector<Vertex> scratch;
+  scratch.clear();
+  return scratch;
+}
+// Clips one triangle against the x, y and far planes and appends the resulting fan to `out`.
+auto clip_triangle(const Vertex &v_a, const Vertex &v_b, const Vertex &v_c, ClipPolygon &v_in, ClipPolygon &v_out, std::vector<Vertex> &out) -> void {
+  v_in.clear();
+  v_out.clear();
+  v_in.push_back(v_a);
+  v_in.push_back(v_b);
+  v_in.push_back(v_c);
+  PLANE_TEST(x, -1, >)
+  v_in = v_out;
+  v_out.clear();
+  PLANE_TEST(x, 1, <)
+  v_in = v_out;
+  v_out.clear();
+  PLANE_TEST(y, -1, >)
+  v_in = v_out;
+  v_out.clear();
+  PLANE_TEST(y, 1, <)
+  v_in = v_out;
+  v_out.clear();
+  PLANE_TEST(z, 1, <)
+  for (size_t k = 2; k < v_out.size(); ++k) {
+    out.push_back(v_out[0]);
+    out.push_back(v_out[k - 1]);
+    out.push_back(v_out[k]);
+  }
+}
+struct Scissor {
+  int64_t min_x;
+  int64_t min_y;
+  int64_t max_x;
+  int64_t max_y;
+};
+template <auto set_pixel> struct FixedSetPixel {
+  auto operator()(Vertex &vertex, Image &image) const -> void { set_pixel(vertex, image); }
+};
+// Counts every fragment into `counters` before handing it to `set_pixel`. It may run on every thread of the tiled
+// rasterizer; tiles never share pixels, so only the counters need atomic updates.
+struct StatsSetPixel {
+  void (*set_pixel)(Vertex &vertex, Image &image);
+  bool depth_test;
+  FragmentCounters *counters;
+
+  static auto count(size_t &counter) -> void { std::atomic_ref<size_t>{counter}.fetch_add(1, std::memory_order_relaxed); }
+  auto operator()(Vertex &vertex, Image &image) const -> void {
+    auto &stats = counters->stats;
+    count(stats.fragments);
+    if (vertex.pos.x < 0 || vertex.pos.y < 0) {
+      count(stats.discarded);
+      return;
+    }
+    size_t x{static_cast<size_t>(vertex.pos.x)};
+    size_t y{static_cast<size_t>(vertex.pos.y)};
+    if (x >= counters->width || y >= counters->height) {
+      count(stats.discarded);
+      return;
+    }
+    // Same comparison as the depth tested set_pixel variants.
+    if (depth_test && vertex.pos.z > image.get_depth(x, y)) {
+      count(stats.depth_failed);
+    } else {
+      count(stats.depth_passed);
+      counters->covered[x + y * counters->width] = 1;
+    }
+    set_pixel(vertex, image);
+  }
+};
+// Hierarchical depth only pays off for set_pixel variants that discard fragments behind the depth buffer.
+auto is_depth_tested(void (*set_pixel)(Vertex &vertex, Image &image)) -> bool {
+  return set_pixel == Alg::set_pixel_rgba_depth || set_pixel == Alg::set_pixel_z_depth || set_pixel == Alg::set_pixel_tex;
+}
+template <auto set_pixel> auto is_depth_tested(FixedSetPixel<set_pixel>) -> bool { return is_depth_tested(set_pixel); }
+auto is_depth_tested(const StatsSetPixel &set_pixel) -> bool { return set_pixel.depth_test; }
+// Fragments the early depth test rejects never reach StatsSetPixel, so they are counted here.
+template <typename SetPixel> auto count_early_depth_failed(const SetPixel &) -> void {}
+auto count_early_depth_failed(const StatsSetPixel &set_pixel) -> void {
+  StatsSetPixel::count(set_pixel.counters->stats.fragments);
+  StatsSetPixel::count(set_pixel.counters->stats.depth_failed);
+}
+// Interpolated depth can round slightly below the smallest vertex depth, so occlusion needs a small margin.
+constexpr Real s_hiz_epsilon{std::numeric_limits<Real>::epsilon() * 1024};
+// Inclusive pixel box of a triangle with the same truncation as the scanline rasterizer, clamped to the scissor.
+auto triangle_box(const Vertex &v_a, const Vertex &v_b, const Vertex &v_c, const Scissor &scissor) -> Scissor {
+  return {std::max(static_cast<int64_t>(std::min({v_a.pos.x, v_b.pos.x, v_c.pos.x})), scissor.min_x), std::max(static_cast<int64_t>(std::min({v_a.pos.y, v_b.pos.y, v_c.pos.y})), scissor.min_y), std::min(static_cast<int64_t>(std::max({v_a.pos.x, v_b.pos.x, v_c.pos.x})), scissor.max_x - 1), std::min(static_cast<int64_t>(std::max({v_a.pos.y, v_b.pos.y, v_c.pos.y})), scissor.max_y - 1)};
+}
+// True when every depth tile under the inclusive pixel box already holds depth nearer than `min_z`.
+auto hiz_occluded(Image &image, const Scissor &box, const Real min_z) -> bool {
+  const auto tile_size = static_cast<int64_t>(Image::depth_tile_size);
+  for (auto tile_y = box.min_y / tile_size; tile_y <= box.max_y / tile_size; ++tile_y) {
+    for (auto tile_x = box.min_x / tile_size; tile_x <= box.max_x / tile_size; ++tile_x) {
+      if (image.get_depth_tile(static_cast<size_t>(tile_x), static_cast<size_t>(tile_y)).max + s_hiz_epsilon >= min_z) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+// The tiled rasterizer counts a triangle once when binning it and tests it again per tile without counting.
+enum class HiZCounting { Counted, Uncounted };
+// Triangle level test shared by every triangle rasterizer. Returns true when the triangle can be skipped.
+template <HiZCounting counting = HiZCounting::Counted, typename SetPixel> auto hiz_reject_triangle(const Vertex &v_a, const Vertex &v_b, const Vertex &v_c, Image &image, SetPixel set_pixel, const Scissor &box) -> bool {
+  if (!image.get_hiz_enabled() || !is_depth_tested(set_pixel) || box.min_x > box.max_x || box.min_y > box.max_y) {
+    return false;
+  }
+  const auto occluded = hiz_occluded(image, box, std::min({v_a.pos.z, v_b.pos.z, v_c.pos.z}));
+  if constexpr (counting == HiZCounting::Counted) {
+    image.add_hiz_stats({.triangles_tested = 1, .triangles_rejected = occluded ? size_t{1} : size_t{0}});
+  }
+  return occluded;
+}
+// Returns how many pixels of the span starting at (x, y) still need shading. Only trailing depth tiles are trimmed,
+// so the incremental attributes of the remaining pixels stay bit identical.
+auto hiz_trim_span(Image &image, const int64_t y, const int64_t x, const int64_t count, const Real min_z) -> int64_t {
+  const auto tile_size = static_cast<int64_t>(Image::depth_tile_size);
+  auto trimmed = count;
+  for (auto tile_x = (x + count - 1) / tile_size; tile_x >= x / tile_size && trimmed > 0; --tile_x) {
+    if (image.get_depth_tile(static_cast<size_t>(tile_x), static_cast<size_t>(y / tile_size)).max + s_hiz_epsilon >= min_z) {
+      break;
+    }
+    trimmed = std::max(tile_x * tile_size - x, int64_t{0});
+  }
+  if (trimmed != count) {
+    image.add_hiz_stats({.spans_rejected = trimmed == 0 ? size_t{1} : size_t{0}, .pixels_rejected = static_cast<size_t>(count - trimmed)});
+  }
+  return trimmed;
+}
+// Marks the depth tiles under a drawn triangle for rebuilding; rasterizers that skip this only leave a stale, still
+// conservative, max behind.
+template <typename SetPixel> auto hiz_invalidate(Image &image, SetPixel set_pixel, const Scissor &box) -> void {
+  if (!is_depth_tested(set_pixel) || box.min_x > box.max_x || box.min_y > box.max_y) {
+    return;
+  }
+  image.invalidate_depth_tiles(static_cast<size_t>(box.min_x), static_cast<size_t>(box.min_y), static_cast<size_t>(box.max_x), static_cast<size_t>(box.max_y));
+}
+enum class DepthTest { Late, Early };
+// Depth of Vertex::interpolate(t, a, b) without touching the other attributes, rounded the same way.
+auto interpolate_depth(const Real t, const Vertex &a, const Vertex &b) -> Real {
+  if (t <= 0.0) {
+    return a.pos.z;
+  }
+  if (t >= 1.0) {
+    return b.pos.z;
+  }
+  return (a.pos.z * (1 - t)) + (b.pos.z * t);
+}
+// With DepthTest::Early only depth is interpolated until the fragment passes the depth test, so `set_pixel` must be
+// one of the depth tested variants.
+template <DepthTest depth_test = DepthTest::Late, HiZCounting counting = HiZCounting::Counted, typename SetPixel> auto rasterize_triangle_scissored(Vertex v_a, Vertex v_b, Vertex v_c, Image &image, SetPixel set_pixel, const Scissor &scissor) -> void {
+  if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x) || std::isnan(v_c.pos.x)) {
+    return;
+  }
+  const auto box = triangle_box(v_a, v_b, v_c, scissor);
+  if (hiz_reject_triangle<counting>(v_a, v_b, v_c, image, set_pixel, box)) {
+    return;
+  }
+  hiz_invalidate(image, set_pixel, box);
+  if (v_a.pos.y > v_b.pos.y) {
+    std::swap(v_a, v_b);
+  }
+  if (v_b.pos.y > v_c.pos.y) {
+    std::swap(v_b, v_c);
+  }
+  if (v_a.pos.y > v_b.pos.y) {
+    std::swap(v_a, v_b);
+  }
+  int64_t start_y = static_cast<int64_t>(v_a.pos.y);
+  int64_t end_y = static_cast<int64_t>(v_b.pos.y);
+  if (start_y != end_y) {
+    for (int64_t y = std::max(start_y, scissor.min_y); y <= std::min(end_y, scissor.max_y - 1); ++y) {
+      const Real t_ab = (y - v_a.pos.y) / (v_b.pos.y - v_a.pos.y);
+      Vertex v_ab = Vertex::interpolate(t_ab, v_a, v_b);
+      const Real t_ac = (y - v_a.pos.y) / (v_c.pos.y - v_a.pos.y);
+      Vertex v_ac = Vertex::interpolate(t_ac, v_a, v_c);
+      if (v_ab.pos.x > v_ac.pos.x) {
+        std::swap(v_ab, v_ac);
+      }
+      int64_t start_x = static_cast<int64_t>(v_ab.pos.x);
+      int64_t end_x = static_cast<int64_t>(v_ac.pos.x);
+      if (start_x == end_x) {
+        continue;
+      }
+      for (int64_t x = std::max(start_x, scissor.min_x); x <= std::min(end_x, scissor.max_x - 1); ++x) {
+        const Real t_abac = (x - v_ab.pos.x) / (v_ac.pos.x - v_ab.pos.x);
+        if constexpr (depth_test == DepthTest::Early) {
+          if (interpolate_depth(t_abac, v_ab, v_ac) > image.get_depth(static_cast<size_t>(x), static_cast<size_t>(y))) {
+            count_early_depth_failed(set_pixel);
+            continue;
+          }
+        }
+        Vertex v_abac = Vertex::interpolate(t_abac, v_ab, v_ac);
+        v_abac.pos.x = static_cast<Real>(x);
+        v_abac.pos.y = static_cast<Real>(y);
+        set_pixel(v_abac, image);
+      }
+    }
+  }
+  start_y = static_cast<int64_t>(v_b.pos.y);
+  end_y = static_cast<int64_t>(v_c.pos.y);
+  if (start_y != end_y) {
+    for (int64_t y = std::max(start_y, scissor.min_y); y <= std::min(end_y, scissor.max_y - 1); ++y) {
+      const Real t_bc = (y - v_b.pos.y) / (v_c.pos.y - v_b.pos.y);
+      Vertex v_bc = Vertex::interpolate(t_bc, v_b, v_c);
+      const Real t_ac = (y - v_a.pos.y) / (v_c.pos.y - v_a.pos.y);
+      Vertex v_ac = Vertex::interpolate(t_ac, v_a, v_c);
+      if (v_bc.pos.x > v_ac.pos.x) {
+        std::swap(v_bc, v_ac);
+      }
+      int64_t start_x = static_cast<int64_t>(v_bc.pos.x);
+      int64_t end_x = static_cast<int64_t>(v_ac.pos.x);
+      if (start_x == end_x) {
+        continue;
+      }
+      for (int64_t x = std::max(start_x, scissor.min_x); x <= std::min(end_x, scissor.max_x - 1); ++x) {
+        const Real t_bcac = (x - v_bc.pos.x) / (v_ac.pos.x - v_bc.pos.x);
+        if constexpr (depth_test == DepthTest::Early) {
+          if (interpolate_depth(t_bcac, v_bc, v_ac) > image.get_depth(static_cast<size_t>(x), static_cast<size_t>(y))) {
+            count_early_depth_failed(set_pixel);
+            continue;
+          }
+        }
+        Vertex v_bcac = Vertex::interpolate(t_bcac, v_bc, v_ac);
+        v_bcac.pos.x = static_cast<Real>(x);
+        v_bcac.pos.y = static_cast<Real>(y);
+        set_pixel(v_bcac, image);
+      }
+    }
+  }
+}
+constexpr int64_t s_subpixel_bits{8};
+constexpr int64_t s_subpixel_one{int64_t{1} << s_subpixel_bits};
+constexpr double s_fixed_limit{static_cast<double>(int64_t{1} << 21)};
+struct Edge {
+  int64_t step_x;
+  int64_t step_y;
+  int64_t value;
+  int64_t bias;
+};
+auto to_fixed(const double value) -> int64_t { return static_cast<int64_t>(std::llround(value * s_subpixel_one)); }
+auto floor_div(const int64_t value, const int64_t divisor) -> int64_t { return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor); }
+auto ceil_div(const int64_t value, const int64_t divisor) -> int64_t { return -floor_div(-value, divisor); }
+auto make_edge(const int64_t x0, const int64_t y0, const int64_t x1, const int64_t y1, const int64_t px, const int64_t py) -> Edge {
+  const auto dx = x1 - x0;
+  const auto dy = y1 - y0;
+  // Top-left rule: of the two triangles sharing an edge only one walks it in the "top-left" direction.
+  const auto top_left = dy > 0 || (dy == 0 && dx > 0);
+  const auto bias = top_left ? int64_t{0} : int64_t{-1};
+  return {-dy * s_subpixel_one, dx * s_subpixel_one, dx * (py - y0) - dy * (px - x0) + bias, bias};
+}
+enum class EdgeSetupResult { Empty, Ready, OutOfRange };
+struct EdgeSetup {
+  int64_t min_x;
+  int64_t min_y;
+  int64_t max_x;
+  int64_t max_y;
+  Edge e_a;
+  Edge e_b;
+  Edge e_c;
+  Vertex origin;
+  Vertex ddx;
+  Vertex ddy;
+};
+auto setup_edges(const Vertex &v_a, const Vertex &v_b, const Vertex &v_c, const Scissor &scissor, EdgeSetup &setup) -> EdgeSetupResult {
+  if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x) || std::isnan(v_c.pos.x)) {
+    return EdgeSetupResult::Empty;
+  }
+  for (const auto *vertex : {&v_a, &v_b, &v_c}) {
+    if (std::abs(vertex->pos.x) > s_fixed_limit || std::abs(vertex->pos.y) > s_fixed_limit) {
+      return EdgeSetupResult::OutOfRange;
+    }
+  }
+  const Vertex *p_a = &v_a;
+  const Vertex *p_b = &v_b;
+  const Vertex *p_c = &v_c;
+  auto ax = to_fixed(v_a.pos.x);
+  auto ay = to_fixed(v_a.pos.y);
+  auto bx = to_fixed(v_b.pos.x);
+  auto by = to_fixed(v_b.pos.y);
+  auto cx = to_fixed(v_c.pos.x);
+  auto cy = to_fixed(v_c.pos.y);
+  auto area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+  if (area == 0) {
+    return EdgeSetupResult::Empty;
+  }
+  if (area < 0) {
+    std::swap(p_b, p_c);
+    std::swap(bx, cx);
+    std::swap(by, cy);
+    area = -area;
+  }
+  setup.min_x = std::max(scissor.min_x, ceil_div(std::min({ax, bx, cx}), s_subpixel_one));
+  setup.min_y = std::max(scissor.min_y, ceil_div(std::min({ay, by, cy}), s_subpixel_one));
+  setup.max_x = std::min(scissor.max_x - 1, floor_div(std::max({ax, bx, cx}), s_subpixel_one));
+  setup.max_y = std::min(scissor.max_y - 1, floor_div(std::max({ay, by, cy}), s_subpixel_one));
+  if (setup.min_x > setup.max_x || setup.min_y > setup.max_y) {
+    return EdgeSetupResult::Empty;
+  }
+  const auto px = setup.min_x * s_subpixel_one;
+  const auto py = setup.min_y * s_subpixel_one;
+  const auto &e_a = setup.e_a = make_edge(bx, by, cx, cy, px, py);
+  const auto &e_b = setup.e_b = make_edge(cx, cy, ax, ay, px, py);
+  const auto &e_c = setup.e_c = make_edge(ax, ay, bx, by, px, py);
+  const Real inv_area = Real{1} / static_cast<Real>(area);
+  setup.origin = ((*p_a * static_cast<Real>(e_a.value - e_a.bias)) + (*p_b * static_cast<Real>(e_b.value - e_b.bias)) + (*p_c * static_cast<Real>(e_c.value - e_c.bias))) * inv_area;
+  setup.ddx = ((*p_a * static_cast<Real>(e_a.step_x)) + (*p_b * static_cast<Real>(e_b.step_x)) + (*p_c * static_cast<Real>(e_c.step_x))) * inv_area;
+  setup.ddy = ((*p_a * static_cast<Real>(e_a.step_y)) + (*p_b * static_cast<Real>(e_b.step_y)) + (*p_c * static_cast<Real>(e_c.step_y))) * inv_area;
+  return EdgeSetupResult::Ready;
+}
+// Calls span_function(y, x, count, vertex) for every covered run of pixels, vertex being the attributes at x.
+template <typename SpanFunction> auto walk_spans(const EdgeSetup &setup, SpanFunction span_function) -> void {
+  auto w_a = setup.e_a.value;
+  auto w_b = setup.e_b.value;
+  auto w_c = setup.e_c.value;
+  Vertex row = setup.origin;
+  for (int64_t y = setup.min_y; y <= setup.max_y; ++y) {
+    // Solve w + k * step_x >= 0 for every edge to get the covered span of the row.
+    int64_t k_min = 0;
+    int64_t k_max = setup.max_x - setup.min_x;
+    for (const auto &[w, edge] : {std::pair{w_a, setup.e_a}, std::pair{w_b, setup.e_b}, std::pair{w_c, setup.e_c}}) {
+      if (edge.step_x > 0) {
+        k_min = std::max(k_min, ceil_div(-w, edge.step_x));
+      } else if (edge.step_x < 0) {
+        k_max = std::min(k_max, floor_div(w, -edge.step_x));
+      } else if (w < 0) {
+        k_max = -1;
+      }
+    }
+    if (k_min <= k_max) {
+      span_function(y, setup.min_x + k_min, k_max - k_min + 1, row + setup.ddx * static_cast<Real>(k_min));
+    }
+    w_a += setup.e_a.step_y;
+    w_b += setup.e_b.step_y;
+    w_c += setup.e_c.step_y;
+    row = row + setup.ddy;
+  }
+}
+template <typename SetPixel> auto rasterize_triangle_edge_scissored(const Vertex &v_a, const Vertex &v_b, const Vertex &v_c, Image &image, SetPixel set_pixel, const Scissor &scissor) -> void {
+  EdgeSetup setup;
+  switch (setup_edges(v_a, v_b, v_c, scissor, setup)) {
+  case EdgeSetupResult::Empty: {
+    return;
+  }
+  case EdgeSetupResult::OutOfRange: {
+    rasterize_triangle_scissored(v_a, v_b, v_c, image, set_pixel, scissor);
+    return;
+  }
+  case EdgeSetupResult::Ready: {
+  } break;
+  }
+  const Scissor box{setup.min_x, setup.min_y, setup.max_x, setup.max_y};
+  if (hiz_reject_triangle(v_a, v_b, v_c, image, set_pixel, box)) {
+    return;
+  }
+  const auto hiz = image.get_hiz_enabled() && is_depth_tested(set_pixel);
+  walk_spans(setup, [&](const int64_t y, const int64_t x, int64_t count, Vertex vertex) {
+    if (hiz) {
+      count = hiz_trim_span(image, y, x, count, std::min(vertex.pos.z, vertex.pos.z + setup.ddx.pos.z * static_cast<Real>(count - 1)));
+    }
+    for (int64_t k = 0; k < count; ++k) {
+      Vertex pixel = vertex;
+      pixel.pos.x = static_cast<Real>(x + k);
+      pixel.pos.y = static_cast<Real>(y);
+      set_pixel(pixel, image);
+      vertex = vertex + setup.ddx;
+    }
+  });
+  hiz_invalidate(image, set_pixel, box);
+}
+auto rasterize_triangle_quad_scissored(const Vertex &v_a, const Vertex &v_b, const Vertex &v_c, Image &image, void (*set_pixel)(Vertex &vertex, Image &image), QuadShader shader, const Scissor &scissor) -> void {
+  EdgeSetup setup;
+  switch (setup_edges(v_a, v_b, v_c, scissor, setup)) {
+  case EdgeSetupResult::Empty: {
+    return;
+  }
+  case EdgeSetupResult::OutOfRange: {
+    rasterize_triangle_scissored(v_a, v_b, v_c, image, set_pixel, scissor);
+    return;
+  }
+  case EdgeSetupResult::Ready: {
+  } break;
+  }
+  const Scissor box{setup.min_x, setup.min_y, setup.max_x, setup.max_y};
+  if (hiz_reject_triangle(v_a, v_b, v_c, image, set_pixel, box)) {
+    return;
+  }
+  const auto hiz = image.get_hiz_enabled() && is_depth_tested(set_pixel);
+  image.resolve(static_cast<size_t>(box.min_x), static_cast<size_t>(box.min_y), static_cast<size_t>(box.max_x), static_cast<size_t>(box.max_y));
+  auto *color = image.get_image_data();
+  auto *depth = image.get_depth_data();
+  const auto width = static_cast<int64_t>(image.get_width());
+  const auto &ddx = setup.ddx;
+  FragmentQuad quad;
+  walk_spans(setup, [&](const int64_t y, const int64_t x, int64_t count, const Vertex &vertex) {
+    if (hiz) {
+      count = hiz_trim_span(image, y, x, count, std::min(vertex.pos.z, vertex.pos.z + ddx.pos.z * static_cast<Real>(count - 1)));
+    }
+    // Same additions as the per-pixel path, so both produce identical values.
+    auto z = vertex.pos.z;
+    auto r = vertex.col.r;
+    auto g = vertex.col.g;
+    auto b = vertex.col.b;
+    auto a = vertex.col.a;
+    auto one = vertex.one;
+    const auto offset = x + y * width;
+    for (int64_t start = 0; start < count; start += static_cast<int64_t>(FragmentQuad::width)) {
+      quad.count = static_cast<size_t>(std::min(count - start, static_cast<int64_t>(FragmentQuad::width)));
+      for (size_t i = 0; i < quad.count; ++i) {
+        quad.z[i] = z;
+        quad.r[i] = r;
+        quad.g[i] = g;
+        quad.b[i] = b;
+        quad.a[i] = a;
+        quad.one[i] = one;
+        z = z + ddx.pos.z;
+        r = r + ddx.col.r;
+        g = g + ddx.col.g;
+        b = b + ddx.col.b;
+        a = a + ddx.col.a;
+        one = one + ddx.one;
+      }
+      shader(quad, color + offset + start, depth + offset + start);
+    }
+  });
+  hiz_invalidate(image, set_pixel, box);
+}
+template <typename SetPixel> auto rasterize_line_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  if (vertices.size() % 2 != 0) {
+    return;
+  }
+  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 2) {
+    auto &v_a = vertices[vertices_index];
+    auto &v_b = vertices[vertices_index + 1];
+    if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x)) {
+      continue;
+    }
+    Real alfa = (v_b.pos.y - v_a.pos.y) / (v_b.pos.x - v_a.pos.x);
+    if (alfa * alfa < 1) {
+      if (v_a.pos.x > v_b.pos.x) {
+        std::swap(v_a, v_b);
+      }
+      for (int64_t x = static_cast<int64_t>(v_a.pos.x); x <= v_b.pos.x; ++x) {
+        if (v_b.pos.x == v_a.pos.x) {
+          continue;
+        }
+        Real t = (x - v_a.pos.x) / (v_b.pos.x - v_a.pos.x);
+        auto vertex = Vertex::interpolate(t, v_a, v_b);
+        if (std::isnan(vertex.pos.x)) {
+          continue;
+        }
+        vertex.pos.x = static_cast<Real>(x);
+        set_pixel(vertex, image);
+      }
+    } else {
+      if (v_a.pos.y > v_b.pos.y) {
+        std::swap(v_a, v_b);
+      }
+      for (int64_t y = static_cast<int64_t>(v_a.pos.y); y <= v_b.pos.y; ++y) {
+        if (v_b.pos.y == v_a.pos.y) {
+          continue;
+        }
+        Real t = (y - v_a.pos.y) / (v_b.pos.y - v_a.pos.y);
+        auto vertex = Vertex::interpolate(t, v_a, v_b);
+        if (std::isnan(vertex.pos.x)) {
+          continue;
+        }
+        vertex.pos.y = static_cast<Real>(y);
+        set_pixel(vertex, image);
+      }
+    }
+  }
+}
+template <typename SetPixel> auto rasterize_point_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  for (auto &vertex : vertices) {
+    set_pixel(vertex, image);
+  }
+}
+template <typename SetPixel> auto rasterize_triangle_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  if (vertices.size() % 3 != 0) {
+    return;
+  }
+  const Scissor scissor{0, 0, static_cast<int64_t>(image.get_width()), static_cast<int64_t>(image.get_height())};
+  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
+    rasterize_triangle_scissored(vertices[vertices_index], vertices[vertices_index + 1], vertices[vertices_index + 2], image, set_pixel, scissor);
+  }
+}
+template <typename SetPixel> auto rasterize_triangle_early_z_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  if (!is_depth_tested(set_pixel)) {
+    rasterize_triangle_impl(vertices, image, set_pixel);
+    return;
+  }
+  if (vertices.size() % 3 != 0) {
+    return;
+  }
+  const Scissor scissor{0, 0, static_cast<int64_t>(image.get_width()), static_cast<int64_t>(image.get_height())};
+  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
+    rasterize_triangle_scissored<DepthTest::Early>(vertices[vertices_index], vertices[vertices_index + 1], vertices[vertices_index + 2], image, set_pixel, scissor);
+  }
+}
+template <typename SetPixel> auto rasterize_triangle_edge_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  if (vertices.size() % 3 != 0) {
+    return;
+  }
+  const Scissor scissor{0, 0, static_cast<int64_t>(image.get_width()), static_cast<int64_t>(image.get_height())};
+  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
+    rasterize_triangle_edge_scissored(vertices[vertices_index], vertices[vertices_index + 1], vertices[vertices_index + 2], image, set_pixel, scissor);
+  }
+}
+template <typename SetPixel> auto rasterize_triangle_tiled_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  if (vertices.size() % 3 != 0) {
+    return;
+  }
+  const auto width = static_cast<int64_t>(image.get_width());
+  const auto height = static_cast<int64_t>(image.get_height());
+  const auto tile_size = static_cast<int64_t>(Image::tile_size);
+  const auto tiles_x = (width + tile_size - 1) / tile_size;
+  const auto tiles_y = (height + tile_size - 1) / tile_size;
+  const Scissor scissor{0, 0, width, height};
+  thread_local std::vector<std::vector<size_t>> bins;
+  bins.resize(static_cast<size_t>(tiles_x * tiles_y));
+  for (auto &bin : bins) {
+    bin.clear();
+  }
+  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
+    const auto &v_a = vertices[vertices_index];
+    const auto &v_b = vertices[vertices_index + 1];
+    const auto &v_c = vertices[vertices_index + 2];
+    if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x) || std::isnan(v_c.pos.x)) {
+      continue;
+    }
+    // Same truncation as the scanline rasterizer, so the box covers every pixel it can touch.
+    const auto box = triangle_box(v_a, v_b, v_c, scissor);
+    if (box.min_x > box.max_x || box.min_y > box.max_y || hiz_reject_triangle(v_a, v_b, v_c, image, set_pixel, box)) {
+      continue;
+    }
+    for (auto tile_y = box.min_y / tile_size; tile_y <= box.max_y / tile_size; ++tile_y) {
+      for (auto tile_x = box.min_x / tile_size; tile_x <= box.max_x / tile_size; ++tile_x) {
+        bins[static_cast<size_t>(tile_x + tile_y * tiles_x)].push_back(vertices_index);
+      }
+    }
+  }
+  const auto rasterize_tile = [&](const size_t tile) {
+    const auto tile_x = static_cast<int64_t>(tile) % tiles_x;
+    const auto tile_y = static_cast<int64_t>(tile) / tiles_x;
+    const Scissor scissor{tile_x * tile_size, tile_y * tile_size, std::min((tile_x + 1) * tile_size, width), std::min((tile_y + 1) * tile_size, height)};
+    for (const auto vertices_index : bins[tile]) {
+      rasterize_triangle_scissored<DepthTest::Late, HiZCounting::Uncounted>(vertices[vertices_index], vertices[vertices_index + 1], vertices[vertices_index + 2], image, set_pixel, scissor);
+    }
+  };
+  ThreadPool::instance().parallel_for(bins.size(), std::ref(rasterize_tile));
+}
+template <typename SetPixel> auto rasterize_triangle_as_lines_impl(std::vector<Vertex> &vertices, Image &image, SetPixel set_pixel) -> void {
+  if (vertices.size() % 3 != 0) {
+    return;
+  }
+  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
+    auto v_a = vertices[vertices_index];
+    auto v_b = vertices[vertices_index + 1];
+    auto v_c = vertices[vertices_index + 2];
+    if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x) || std::isnan(v_c.pos.x)) {
+      continue;
+    }
+    thread_local std::vector<Vertex> line_vertices;
+    line_vertices.assign({v_a, v_b, v_b, v_c, v_c, v_a});
+    rasterize_line_impl(line_vertices, image, set_pixel);
+  }
+}
+template <typename Rasterize> auto specialize_set_pixel(void (*set_pixel)(Vertex &vertex, Image &image)) -> void (*)(std::vector<Vertex> &vertices, Image &image) {
+  if (set_pixel == Alg::set_pixel_rgba_depth) {
+    return [](std::vector<Vertex> &vertices, Image &image) { Rasterize{}(vertices, image, FixedSetPixel<Alg::set_pixel_rgba_depth>{}); };
+  }
+  if (set_pixel == Alg::set_pixel_rgba_no_depth) {
+    return [](std::vector<Vertex> &vertices, Image &image) { Rasterize{}(vertices, image, FixedSetPixel<Alg::set_pixel_rgba_no_depth>{}); };
+  }
+  if (set_pixel == Alg::set_pixel_z_depth) {
+    return [](std::vector<Vertex> &vertices, Image &image) { Rasterize{}(vertices, image, FixedSetPixel<Alg::set_pixel_z_depth>{}); };
+  }
+  if (set_pixel == Alg::set_pixel_z_no_depth) {
+    return [](std::vector<Vertex> &vertices, Image &image) { Rasterize{}(vertices, image, FixedSetPixel<Alg::set_pixel_z_no_depth>{}); };
+  }
+  if (set_pixel == Alg::set_pixel_tex) {
+    return [](std::vector<Vertex> &vertices, Image &image) { Rasterize{}(vertices, image, FixedSetPixel<Alg::set_pixel_tex>{}); };
+  }
+  if (set_pixel == Alg::set_pixel_white) {
+    return [](std::vector<Vertex> &vertices, Image &image) { Rasterize{}(vertices, image, FixedSetPixel<Alg::set_pixel_white>{}); };
+  }
+  return nullptr;
+}
+template <typename Index> auto fetch_triangles_by_stream_impl(std::span<const Vertex> vertices, std::span<const Index> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void {
+  out.clear();
+  if (indices.empty() || indices.size() % 3 != 0) {
+    return;
+  }
+  // Only index ranges that touch a small part of a big vertex buffer pay for
+  // finding the referenced range, like VertexCache.
+  size_t first = 0;
+  auto range = vertices;
+  if (vertices.size() > indices.size()) {
+    const auto [min_index, max_index] = std::minmax_element(indices.begin(), indices.end());
+    first = *min_index;
+    range = vertices.subspan(first, *max_index - first + 1);
+  }
+  thread_local VertexStream stream;
+  thread_local std::vector<uint8_t> outcodes;
+  stream.load(range);
+  Alg::trasform_stream_by_matrix(stream, matrix);
+  Alg::classify_stream(stream, outcodes);
+  out.reserve(indices.size());
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const size_t i_a = indices[i] - first;
+    const size_t i_b = indices[i + 1] - first;
+    const size_t i_c = indices[i + 2] - first;
+    if ((outcodes[i_a] & outcodes[i_b] & outcodes[i_c]) != 0) {
+      continue;
+    }
+    for (const auto index : {i_a, i_b, i_c}) {
+      auto &vertex = out.emplace_back(range[index]);
+      vertex.pos = stream.get_position(index);
+    }
+  }
+}
+template <typename Index> auto fetch_vertices_by_matrix_impl(std::span<const Vertex> vertices, std::span<const Index> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void {
+  thread_local VertexCache cache;
+  cache.fetch(vertices, indices, matrix, out);
+}
+template <typename Index> auto fetch_vertices_indexed_impl(std::span<const Vertex> vertices, std::span<const Index> indices, const glm::dmat4 &, std::vector<Vertex> &out) -> void {
+  out.clear();
+  out.reserve(indices.size());
+  for (const auto index : indices) {
+    out.push_back(vertices[index]);
+  }
+}
+} // namespace
 namespace Alg {
 
 auto clip_after_dehomog_line(std::vector<Vertex> &vertices) -> void {
@@ -72,72 +735,50 @@ auto clip_after_dehomog_line(std::vector<Vertex> &vertices) -> void {
   }
 }
 
+auto clip_after_dehomog_guard_band(std::vector<Vertex> &vertices) -> void {
+  GuardBandStats stats;
+  clip_to_guard_band(vertices, default_guard_band, stats);
+}
 auto clip_after_dehomog_none(std::vector<Vertex> &) -> void {}
 auto clip_after_dehomog_triangle(std::vector<Vertex> &vertices) -> void {
   if (vertices.size() % 3 != 0) {
     return;
   }
-  static std::vector<Vertex> new_vertices;
-  new_vertices.clear();
-  static std::vector<Vertex> v_in(9);
-  static std::vector<Vertex> v_out(9);
-  new_vertices.reserve(vertices.size() * 9);
+  auto &new_vertices = clip_scratch();
+  ClipPolygon v_in;
+  ClipPolygon v_out;
+  new_vertices.reserve(vertices.size());
   for (size_t i = 0; i < vertices.size(); i += 3) {
-    v_in.clear();
-    v_out.clear();
-    v_in.push_back(vertices[i]);
-    v_in.push_back(vertices[i + 1]);
-    v_in.push_back(vertices[i + 2]);
-    PLANE_TEST(x, -1, >)
-    v_in = v_out;
-    v_out.clear();
-    PLANE_TEST(x, 1, <)
-    v_in = v_out;
-    v_out.clear();
-    PLANE_TEST(y, -1, >)
-    v_in = v_out;
-    v_out.clear();
-    PLANE_TEST(y, 1, <)
-    v_in = v_out;
-    v_out.clear();
-    PLANE_TEST(z, 1, <)
-    for (size_t k = 2; k < v_out.size(); ++k) {
-      new_vertices.push_back(v_out[0]);
-      new_vertices.push_back(v_out[k - 1]);
-      new_vertices.push_back(v_out[k]);
-    }
-  }
-  vertices = new_vertices;
+    clip_triangle(vertices[i], vertices[i + 1], vertices[i + 2], v_in, v_out, new_vertices);
+  }
+  vertices.swap(new_vertices);
 }
 
 auto clip_backface_none(std::vector<Vertex> &) -> void {}
 
 auto clip_backface_triangle(std::vector<Vertex> &vertices) -> void {
     if (vertices.size() % 3 != 0) { return; }
-    std::vector<Vertex> new_vertices;
-    new_vertices.reserve(vertices.size());
+    size_t count = 0;
     for (size_t i = 0; i < vertices.size(); i += 3) {
         auto &v1 = vertices[i];
         auto &v2 = vertices[i + 1];
         auto &v3 = vertices[i + 2];
-        const auto a = glm::dvec3((v2.pos/v2.pos.w) - (v1.pos/v1.pos.w));
-        const auto b = glm::dvec3((v3.pos/v3.pos.w) - (v1.pos/v1.pos.w));
+        const auto a = Vec3((v2.pos/v2.pos.w) - (v1.pos/v1.pos.w));
+        const auto b = Vec3((v3.pos/v3.pos.w) - (v1.pos/v1.pos.w));
         const auto n = glm::cross(a, b);
-        const auto bfc = glm::dot(n, glm::dvec3(0, 0, 1));
+        const auto bfc = glm::dot(n, Vec3(0, 0, 1));
         if (bfc <= 0) { continue; }
-        new_vertices.push_back(v1);
-        new_vertices.push_back(v2);
-        new_vertices.push_back(v3);
+        vertices[count++] = v1;
+        vertices[count++] = v2;
+        vertices[count++] = v3;
     }
-    vertices = new_vertices;
+    vertices.resize(count);
 }
 
 auto clip_before_dehomog_line(std::vector<Vertex> &vertices) -> void {
   if (vertices.size() % 2 != 0) {
     return;
   }
-  std::vector<Vertex> new_vertices;
-  new_vertices.reserve(vertices.size());
   for (size_t i = 0; i < vertices.size(); i += 2) {
     auto &v1 = vertices[i];
     auto &v2 = vertices[i + 1];
@@ -146,20 +787,17 @@ auto clip_before_dehomog_line(std::vector<Vertex> &vertices) -> void {
       std::swap(v1, v2);
     }
     if (v1.pos.z <= 0) {
-      const double t_21 = (0 - v2.pos.z) / (v1.pos.z - v2.pos.z);
+      const Real t_21 = (0 - v2.pos.z) / (v1.pos.z - v2.pos.z);
       v1 = Vertex::interpolate(t_21, v2, v1);
     }
-    new_vertices.push_back(v1);
-    new_vertices.push_back(v2);
   }
-  vertices = new_vertices;
 }
 auto clip_before_dehomog_none(std::vector<Vertex> &) -> void {}
 auto clip_before_dehomog_triangle(std::vector<Vertex> &vertices) -> void {
   if (vertices.size() % 3 != 0) {
     return;
   }
-  std::vector<Vertex> new_vertices;
+  auto &new_vertices = clip_scratch();
   new_vertices.reserve(vertices.size() * 2);
   for (size_t i = 0; i < vertices.size(); i += 3) {
     auto &v1 = vertices[i];
@@ -182,17 +820,17 @@ auto clip_before_dehomog_triangle(std::vector<Vertex> &vertices) -> void {
       std::swap(v1, v2);
     }
     if (v2.pos.z <= 0) {
-      const double t_32 = (0 - v3.pos.z) / (v2.pos.z - v3.pos.z);
+      const Real t_32 = (0 - v3.pos.z) / (v2.pos.z - v3.pos.z);
       v2 = Vertex::interpolate(t_32, v3, v2);
-      const double t_31 = (0 - v3.pos.z) / (v1.pos.z - v3.pos.z);
+      const Real t_31 = (0 - v3.pos.z) / (v1.pos.z - v3.pos.z);
       v1 = Vertex::interpolate(t_31, v3, v1);
       new_vertices.push_back(v1);
       new_vertices.push_back(v2);
       new_vertices.push_back(v3);
     } else {
-      const double t_21 = (0 - v2.pos.z) / (v1.pos.z - v2.pos.z);
+      const Real t_21 = (0 - v2.pos.z) / (v1.pos.z - v2.pos.z);
       auto v21 = Vertex::interpolate(t_21, v2, v1);
-      const double t_31 = (0 - v3.pos.z) / (v1.pos.z - v3.pos.z);
+      const Real t_31 = (0 - v3.pos.z) / (v1.pos.z - v3.pos.z);
       auto v31 = Vertex::interpolate(t_31, v3, v1);
       new_vertices.push_back(v21);
       new_vertices.push_back(v31);
@@ -202,44 +840,41 @@ auto clip_before_dehomog_triangle(std::vector<Vertex> &vertices) -> void {
       new_vertices.push_back(v3);
     }
   }
-  vertices = new_vertices;
+  vertices.swap(new_vertices);
 }
 auto clip_fast_line(std::vector<Vertex> &vertices) -> void {
   if (vertices.size() % 2 != 0) {
     return;
   }
-  std::vector<Vertex> new_vertices;
-  new_vertices.reserve(vertices.size());
+  size_t count = 0;
   for (size_t i = 0; i < vertices.size(); i += 2) {
     const auto &v1 = vertices[i];
     const auto &v2 = vertices[i + 1];
     if ((v1.pos.x < -v1.pos.w && v2.pos.x < -v2.pos.w) || (v1.pos.x > v1.pos.w && v2.pos.x > v2.pos.w) || (v1.pos.y < -v1.pos.w && v2.pos.y < -v2.pos.w) || (v1.pos.y > v1.pos.w && v2.pos.y > v2.pos.w) || (v1.pos.z < 0 && v2.pos.z < 0) || (v1.pos.z > v1.pos.w && v2.pos.z > v2.pos.w)) {
       continue;
     }
-    new_vertices.push_back(v1);
-    new_vertices.push_back(v2);
+    vertices[count++] = v1;
+    vertices[count++] = v2;
   }
-  vertices = new_vertices;
+  vertices.resize(count);
 }
 auto clip_fast_none(std::vector<Vertex> &) -> void {}
 auto clip_fast_point(std::vector<Vertex> &vertices) -> void {
-  std::vector<Vertex> new_vertices;
-  new_vertices.reserve(vertices.size());
+  size_t count = 0;
   for (size_t i = 0; i < vertices.size(); ++i) {
     const auto &v1 = vertices[i];
     if ((v1.pos.x < -v1.pos.w) || (v1.pos.x > v1.pos.w) || (v1.pos.y < -v1.pos.w) || (v1.pos.y > v1.pos.w) || (v1.pos.z < 0) || (v1.pos.z > v1.pos.w)) {
       continue;
     }
-    new_vertices.push_back(v1);
+    vertices[count++] = v1;
   }
-  vertices = new_vertices;
+  vertices.resize(count);
 }
 auto clip_fast_triangle(std::vector<Vertex> &vertices) -> void {
   if (vertices.size() % 3 != 0) {
     return;
   }
-  std::vector<Vertex> new_vertices;
-  new_vertices.reserve(vertices.size());
+  size_t count = 0;
   for (size_t i = 0; i < vertices.size(); i += 3) {
     const auto &v1 = vertices[i];
     const auto &v2 = vertices[i + 1];
@@ -247,11 +882,47 @@ auto clip_fast_triangle(std::vector<Vertex> &vertices) -> void {
     if ((v1.pos.x < -v1.pos.w && v2.pos.x < -v2.pos.w && v3.pos.x < -v3.pos.w) || (v1.pos.x > v1.pos.w && v2.pos.x > v2.pos.w && v3.pos.x > v3.pos.w) || (v1.pos.y < -v1.pos.w && v2.pos.y < -v2.pos.w && v3.pos.y < -v3.pos.w) || (v1.pos.y > v1.pos.w && v2.pos.y > v2.pos.w && v3.pos.y > v3.pos.w) || (v1.pos.z < 0 && v2.pos.z < 0 && v3.pos.z < 0) || (v1.pos.z > v1.pos.w && v2.pos.z > v2.pos.w && v3.pos.z > v3.pos.w)) {
       continue;
     }
-    new_vertices.push_back(v1);
-    new_vertices.push_back(v2);
-    new_vertices.push_back(v3);
+    vertices[count++] = v1;
+    vertices[count++] = v2;
+    vertices[count++] = v3;
+  }
+  vertices.resize(count);
+}
+auto clip_to_guard_band(std::vector<Vertex> &vertices, const Real guard_band, GuardBandStats &stats) -> void {
+  if (vertices.size() % 3 != 0) {
+    return;
+  }
+  auto &new_vertices = clip_scratch();
+  ClipPolygon v_in;
+  ClipPolygon v_out;
+  new_vertices.reserve(vertices.size());
+  const auto band = std::max(guard_band, Real{1});
+  for (size_t i = 0; i < vertices.size(); i += 3) {
+    const auto &v1 = vertices[i];
+    const auto &v2 = vertices[i + 1];
+    const auto &v3 = vertices[i + 2];
+    const auto min_x = std::min({v1.pos.x, v2.pos.x, v3.pos.x});
+    const auto max_x = std::max({v1.pos.x, v2.pos.x, v3.pos.x});
+    const auto min_y = std::min({v1.pos.y, v2.pos.y, v3.pos.y});
+    const auto max_y = std::max({v1.pos.y, v2.pos.y, v3.pos.y});
+    const auto max_z = std::max({v1.pos.z, v2.pos.z, v3.pos.z});
+    // Triangles that stay inside the guard band only need the rasterizer's scissor, everything else is clipped.
+    if (max_z <= 1 && min_x >= -band && max_x <= band && min_y >= -band && max_y <= band) {
+      if (min_x >= -1 && max_x <= 1 && min_y >= -1 && max_y <= 1) {
+        ++stats.inside;
+      } else {
+        ++stats.guard_band;
+      }
+      new_vertices.push_back(v1);
+      new_vertices.push_back(v2);
+      new_vertices.push_back(v3);
+      continue;
+    }
+    const auto count = new_vertices.size();
+    clip_triangle(v1, v2, v3, v_in, v_out, new_vertices);
+    ++(new_vertices.size() == count ? stats.culled : stats.clipped);
   }
-  vertices = new_vertices;
+  vertices.swap(new_vertices);
 }
 auto dehomog_all(std::vector<Vertex> &vertices) -> void {
   for (auto &vertex : vertices) {
@@ -270,156 +941,83 @@ auto dehomog_pos(std::vector<Vertex> &vertices) -> void {
     vertex.pos /= w;
   }
 }
+// Transforms the referenced index range as a stream and drops triangles that lie outside one frustum plane, like clip_fast_triangle.
+auto fetch_triangles_by_stream(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void {
+  fetch_triangles_by_stream_impl(vertices, indices, matrix, out);
+}
+auto get_fragment_stats(const FragmentCounters &counters) -> FragmentStats {
+  auto stats = counters.stats;
+  stats.pixels_covered = static_cast<size_t>(std::count(counters.covered.begin(), counters.covered.end(), 1));
+  return stats;
+}
+auto begin_fragment_stats(FragmentCounters &counters, const Image &image) -> void {
+  counters.stats = {};
+  counters.covered.assign(image.get_width() * image.get_height(), 0);
+  counters.width = image.get_width();
+  counters.height = image.get_height();
+}
+auto fetch_vertices_by_matrix(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void {
+  fetch_vertices_by_matrix_impl(vertices, indices, matrix, out);
+}
+auto fetch_vertices_indexed(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void {
+  fetch_vertices_indexed_impl(vertices, indices, matrix, out);
+}
 auto trasform_to_none(std::vector<Vertex> &, const Image &) -> void {}
 auto trasform_to_viewport(std::vector<Vertex> &vertices, const Image &image) -> void {
   for (auto &vertex : vertices) {
-    vertex.pos.x = ((vertex.pos.x + 1.0) / 2.0) * (image.get_width() - 1);
-    vertex.pos.y = ((vertex.pos.y + 1.0) / 2.0) * (image.get_height() - 1);
+    vertex.pos.x = ((vertex.pos.x + 1) / 2) * static_cast<Real>(image.get_width() - 1);
+    vertex.pos.y = ((vertex.pos.y + 1) / 2) * static_cast<Real>(image.get_height() - 1);
   }
 }
 auto trasform_vertices_by_matrix(std::vector<Vertex> &vertices, const glm::dmat4 &matrix) -> void {
+  const Mat4 transform{matrix};
   for (auto &vertex : vertices) {
-    vertex.pos = matrix * vertex.pos;
+    vertex.pos = transform * vertex.pos;
   }
 }
 auto trasform_vertices_by_none(std::vector<Vertex> &, const glm::dmat4 &) -> void {}
-auto rasterize_line(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void {
-  if (vertices.size() % 2 != 0) {
-    return;
-  }
-  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 2) {
-    auto &v_a = vertices[vertices_index];
-    auto &v_b = vertices[vertices_index + 1];
-    if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x)) {
-      continue;
-    }
-    double alfa = (v_b.pos.y - v_a.pos.y) / (v_b.pos.x - v_a.pos.x);
-    if (alfa * alfa < 1) {
-      if (v_a.pos.x > v_b.pos.x) {
-        std::swap(v_a, v_b);
-      }
-      for (int64_t x = static_cast<int64_t>(v_a.pos.x); x <= v_b.pos.x; ++x) {
-        if (v_b.pos.x == v_a.pos.x) {
-          continue;
-        }
-        double t = (x - v_a.pos.x) / (v_b.pos.x - v_a.pos.x);
-        auto vertex = Vertex::interpolate(t, v_a, v_b);
-        if (std::isnan(vertex.pos.x)) {
-          continue;
-        }
-        vertex.pos.x = static_cast<double>(x);
-        set_pixel(vertex, image);
-      }
-    } else {
-      if (v_a.pos.y > v_b.pos.y) {
-        std::swap(v_a, v_b);
-      }
-      for (int64_t y = static_cast<int64_t>(v_a.pos.y); y <= v_b.pos.y; ++y) {
-        if (v_b.pos.y == v_a.pos.y) {
-          continue;
-        }
-        double t = (y - v_a.pos.y) / (v_b.pos.y - v_a.pos.y);
-        auto vertex = Vertex::interpolate(t, v_a, v_b);
-        if (std::isnan(vertex.pos.x)) {
-          continue;
-        }
-        vertex.pos.y = static_cast<double>(y);
-        set_pixel(vertex, image);
-      }
-    }
-  }
-}
+auto rasterize_line(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_line_impl(vertices, image, set_pixel); }
 auto rasterize_none(std::vector<Vertex> &, Image &, void (*)(Vertex &, Image &)) -> void {}
-auto rasterize_point(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void {
-  for (auto &vertex : vertices) {
-    set_pixel(vertex, image);
-  }
-}
-auto rasterize_triangle(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void {
+auto rasterize_point(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_point_impl(vertices, image, set_pixel); }
+auto rasterize_triangle(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_triangle_impl(vertices, image, set_pixel); }
+auto rasterize_triangle_early_z(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_triangle_early_z_impl(vertices, image, set_pixel); }
+auto rasterize_triangle_edge(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_triangle_edge_impl(vertices, image, set_pixel); }
+auto rasterize_triangle_quad(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void {
   if (vertices.size() % 3 != 0) {
     return;
   }
-  for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
-    auto v_a = vertices[vertices_index];
-    auto v_b = vertices[vertices_index + 1];
-    auto v_c = vertices[vertices_index + 2];
-    if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x) || std::isnan(v_c.pos.x)) {
-      continue;
-    }
-    if (v_a.pos.y > v_b.pos.y) {
-      std::swap(v_a, v_b);
-    }
-    if (v_b.pos.y > v_c.pos.y) {
-      std::swap(v_b, v_c);
-    }
-    if (v_a.pos.y > v_b.pos.y) {
-      std::swap(v_a, v_b);
-    }
-    int64_t start_y = static_cast<int64_t>(v_a.pos.y);
-    int64_t end_y = static_cast<int64_t>(v_b.pos.y);
-    if (start_y != end_y) {
-      for (int64_t y = start_y; y <= end_y; ++y) {
-        const double t_ab = (y - v_a.pos.y) / (v_b.pos.y - v_a.pos.y);
-        Vertex v_ab = Vertex::interpolate(t_ab, v_a, v_b);
-        const double t_ac = (y - v_a.pos.y) / (v_c.pos.y - v_a.pos.y);
-        Vertex v_ac = Vertex::interpolate(t_ac, v_a, v_c);
-        if (v_ab.pos.x > v_ac.pos.x) {
-          std::swap(v_ab, v_ac);
-        }
-        int64_t start_x = static_cast<int64_t>(v_ab.pos.x);
-        int64_t end_x = static_cast<int64_t>(v_ac.pos.x);
-        if (start_x == end_x) {
-          continue;
-        }
-        for (int64_t x = start_x; x <= end_x; ++x) {
-          const double t_abac = (x - v_ab.pos.x) / (v_ac.pos.x - v_ab.pos.x);
-          Vertex v_abac = Vertex::interpolate(t_abac, v_ab, v_ac);
-          v_abac.pos.x = static_cast<double>(x);
-          v_abac.pos.y = static_cast<double>(y);
-          set_pixel(v_abac, image);
-        }
-      }
-    }
-    start_y = static_cast<int64_t>(v_b.pos.y);
-    end_y = static_cast<int64_t>(v_c.pos.y);
-    if (start_y != end_y) {
-      for (int64_t y = start_y; y <= end_y; ++y) {
-        const double t_bc = (y - v_b.pos.y) / (v_c.pos.y - v_b.pos.y);
-        Vertex v_bc = Vertex::interpolate(t_bc, v_b, v_c);
-        const double t_ac = (y - v_a.pos.y) / (v_c.pos.y - v_a.pos.y);
-        Vertex v_ac = Vertex::interpolate(t_ac, v_a, v_c);
-        if (v_bc.pos.x > v_ac.pos.x) {
-          std::swap(v_bc, v_ac);
-        }
-        int64_t start_x = static_cast<int64_t>(v_bc.pos.x);
-        int64_t end_x = static_cast<int64_t>(v_ac.pos.x);
-        if (start_x == end_x) {
-          continue;
-        }
-        for (int64_t x = start_x; x <= end_x; ++x) {
-          const double t_bcac = (x - v_bc.pos.x) / (v_ac.pos.x - v_bc.pos.x);
-          Vertex v_bcac = Vertex::interpolate(t_bcac, v_bc, v_ac);
-          v_bcac.pos.x = static_cast<double>(x);
-          v_bcac.pos.y = static_cast<double>(y);
-          set_pixel(v_bcac, image);
-        }
-      }
-    }
-  }
-}
-auto rasterize_triangle_as_lines(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void {
-  if (vertices.size() % 3 != 0) {
+  // Quad shaders write Real depth directly, packed depth formats go through set_pixel.
+  const auto shader = image.get_depth_format() == DepthFormat::Native ? quad_shader(set_pixel) : nullptr;
+  if (!shader) {
+    rasterize_triangle_edge(vertices, image, set_pixel);
     return;
   }
+  const Scissor scissor{0, 0, static_cast<int64_t>(image.get_width()), static_cast<int64_t>(image.get_height())};
   for (size_t vertices_index = 0; vertices_index < vertices.size(); vertices_index += 3) {
-    auto v_a = vertices[vertices_index];
-    auto v_b = vertices[vertices_index + 1];
-    auto v_c = vertices[vertices_index + 2];
-    if (std::isnan(v_a.pos.x) || std::isnan(v_b.pos.x) || std::isnan(v_c.pos.x)) {
-      continue;
-    }
-    std::vector<Vertex> line_vertices = {v_a, v_b, v_b, v_c, v_c, v_a};
-    rasterize_line(line_vertices, image, set_pixel);
+    rasterize_triangle_quad_scissored(vertices[vertices_index], vertices[vertices_index + 1], vertices[vertices_index + 2], image, set_pixel, shader, scissor);
+  }
+}
+auto rasterize_triangle_tiled(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_triangle_tiled_impl(vertices, image, set_pixel); }
+auto rasterize_triangle_as_lines(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void { rasterize_triangle_as_lines_impl(vertices, image, set_pixel); }
+auto rasterize_stats(void (*rasterize)(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)), std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image), FragmentCounters &counters) -> void {
+  const StatsSetPixel stats_set_pixel{set_pixel, is_depth_tested(set_pixel), &counters};
+  if (rasterize == rasterize_triangle) {
+    rasterize_triangle_impl(vertices, image, stats_set_pixel);
+  } else if (rasterize == rasterize_triangle_early_z) {
+    rasterize_triangle_early_z_impl(vertices, image, stats_set_pixel);
+  } else if (rasterize == rasterize_triangle_edge || rasterize == rasterize_triangle_quad) {
+    // Quad shaders write the buffers directly, so counted quads take the per-pixel path.
+    rasterize_triangle_edge_impl(vertices, image, stats_set_pixel);
+  } else if (rasterize == rasterize_triangle_tiled) {
+    rasterize_triangle_tiled_impl(vertices, image, stats_set_pixel);
+  } else if (rasterize == rasterize_triangle_as_lines) {
+    rasterize_triangle_as_lines_impl(vertices, image, stats_set_pixel);
+  } else if (rasterize == rasterize_line) {
+    rasterize_line_impl(vertices, image, stats_set_pixel);
+  } else if (rasterize == rasterize_point) {
+    rasterize_point_impl(vertices, image, stats_set_pixel);
+  } else {
+    rasterize(vertices, image, set_pixel);
   }
 }
 auto set_pixel_none(Vertex &, Image &) -> void {}
@@ -429,7 +1027,7 @@ auto set_pixel_rgba_no_depth(Vertex &vertex, Image &image) -> void {
   }
   size_t x{static_cast<size_t>(vertex.pos.x)};
   size_t y{static_cast<size_t>(vertex.pos.y)};
-  image.set_pixel(x, y, vertex.col * 1.0 / vertex.one);
+  image.set_pixel(x, y, vertex.col / vertex.one);
 }
 auto set_pixel_rgba_depth(Vertex &vertex, Image &image) -> void {
   if (vertex.pos.x < 0 || vertex.pos.y < 0) {
@@ -441,7 +1039,7 @@ auto set_pixel_rgba_depth(Vertex &vertex, Image &image) -> void {
     return;
   }
   image.set_depth(x, y, vertex.pos.z);
-  image.set_pixel(x, y, vertex.col * 1.0 / vertex.one);
+  image.set_pixel(x, y, vertex.col / vertex.one);
 }
 auto set_pixel_z_depth(Vertex &vertex, Image &image) -> void {
   if (vertex.pos.x < 0 || vertex.pos.y < 0) {
@@ -475,9 +1073,9 @@ auto set_pixel_tex(Vertex &vertex, Image &image) -> void {
   auto r = vertex.col.r / vertex.one;
   auto g = vertex.col.g / vertex.one;
   auto b = vertex.col.b / vertex.one;
-  bool r_t = static_cast<int>(r * 10.0) % 2 == 0;
-  bool g_t = static_cast<int>(g * 10.0) % 2 == 0;
-  bool b_t = static_cast<int>(b * 10.0) % 2 == 0;
+  bool r_t = static_cast<int>(r * 10) % 2 == 0;
+  bool g_t = static_cast<int>(g * 10) % 2 == 0;
+  bool b_t = static_cast<int>(b * 10) % 2 == 0;
   if ((r_t && g_t && !b_t) || (r_t && !g_t && b_t) || (!r_t && g_t && b_t)) {
     r = 1.0;
     g = 1.0;
@@ -495,5 +1093,43 @@ auto set_pixel_white(Vertex &vertex, Image &image) -> void {
   size_t y{static_cast<size_t>(vertex.pos.y)};
   image.set_pixel(x, y, {1.0, 1.0, 1.0, 1.0});
 }
+auto specialize_rasterize(void (*rasterize)(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)), void (*set_pixel)(Vertex &vertex, Image &image)) -> void (*)(std::vector<Vertex> &vertices, Image &image) {
+  if (rasterize == rasterize_triangle) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_triangle_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  if (rasterize == rasterize_triangle_early_z) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_triangle_early_z_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  if (rasterize == rasterize_triangle_edge) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_triangle_edge_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  if (rasterize == rasterize_triangle_tiled) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_triangle_tiled_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  if (rasterize == rasterize_triangle_as_lines) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_triangle_as_lines_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  if (rasterize == rasterize_line) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_line_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  if (rasterize == rasterize_point) {
+    return specialize_set_pixel<decltype([](std::vector<Vertex> &vertices, Image &image, auto set_pixel) { rasterize_point_impl(vertices, image, set_pixel); })>(set_pixel);
+  }
+  return nullptr;
+}
+template <typename Index> auto specialize_fetch_vertices(void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out)) -> void (*)(std::span<const Vertex> vertices, std::span<const Index> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) {
+  if (fetch_vertices == fetch_vertices_by_matrix) {
+    return fetch_vertices_by_matrix_impl<Index>;
+  }
+  if (fetch_vertices == fetch_vertices_indexed) {
+    return fetch_vertices_indexed_impl<Index>;
+  }
+  if (fetch_vertices == fetch_triangles_by_stream) {
+    return fetch_triangles_by_stream_impl<Index>;
+  }
+  return nullptr;
+}
+template auto specialize_fetch_vertices<uint16_t>(void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out)) -> void (*)(std::span<const Vertex> vertices, std::span<const uint16_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out);
+template auto specialize_fetch_vertices<uint32_t>(void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out)) -> void (*)(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out);
 } // namespace Alg
 } // namespace Vis
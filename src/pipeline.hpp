@@ -3,9 +3,39 @@
 #include "image.hpp"
 #include "vertex.hpp"
 // std includes
+#include <span>
 #include <vector>
 namespace Vis {
+// Half size of the guard band clip_after_dehomog_guard_band leaves to the
+// rasterizer's scissor, in normalized device coordinates.
+constexpr Real default_guard_band{4};
+// Triangles seen by Alg::clip_to_guard_band, split by how they were handled.
+struct GuardBandStats {
+  size_t inside{0};
+  size_t guard_band{0};
+  size_t clipped{0};
+  size_t culled{0};
+};
+// Fragments seen by Alg::rasterize_stats since the last begin_fragment_stats,
+// including those rasterize_triangle_early_z rejects before shading.
+// Discarded fragments fall outside the image, e.g. from the guard band.
+struct FragmentStats {
+  size_t fragments{0};
+  size_t depth_passed{0};
+  size_t depth_failed{0};
+  size_t discarded{0};
+  size_t pixels_covered{0};
+};
+// Where Alg::rasterize_stats counts, owned by the caller so every renderer
+// keeps its own.
+struct FragmentCounters {
+  FragmentStats stats{};
+  std::vector<uint8_t> covered{};
+  size_t width{0};
+  size_t height{0};
+};
 namespace Alg {
+auto clip_after_dehomog_guard_band(std::vector<Vertex> &vertices) -> void;
 auto clip_after_dehomog_line(std::vector<Vertex> &vertices) -> void;
 auto clip_after_dehomog_none(std::vector<Vertex> &vertices) -> void;
 auto clip_after_dehomog_triangle(std::vector<Vertex> &vertices) -> void;
@@ -18,14 +48,27 @@ auto clip_fast_line(std::vector<Vertex> &vertices) -> void;
 auto clip_fast_none(std::vector<Vertex> &) -> void;
 auto clip_fast_point(std::vector<Vertex> &vertices) -> void;
 auto clip_fast_triangle(std::vector<Vertex> &vertices) -> void;
+// clip_after_dehomog_guard_band with a guard band of `guard_band`, adding to `stats`.
+auto clip_to_guard_band(std::vector<Vertex> &vertices, Real guard_band, GuardBandStats &stats) -> void;
 auto dehomog_all(std::vector<Vertex> &vertices) -> void;
 auto dehomog_none(std::vector<Vertex> &vertices) -> void;
 auto dehomog_pos(std::vector<Vertex> &vertices) -> void;
+auto begin_fragment_stats(FragmentCounters &counters, const Image &image) -> void;
+auto fetch_vertices_by_matrix(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void;
+auto fetch_triangles_by_stream(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void;
+auto fetch_vertices_indexed(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void;
+auto get_fragment_stats(const FragmentCounters &counters) -> FragmentStats;
 auto rasterize_line(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
 auto rasterize_none(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
 auto rasterize_point(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
 auto rasterize_triangle(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
+auto rasterize_triangle_early_z(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
+auto rasterize_triangle_edge(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
+auto rasterize_triangle_quad(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
+auto rasterize_triangle_tiled(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
 auto rasterize_triangle_as_lines(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)) -> void;
+// Runs `rasterize` with `set_pixel`, counting every fragment into `counters`.
+auto rasterize_stats(void (*rasterize)(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)), std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image), FragmentCounters &counters) -> void;
 auto set_pixel_none(Vertex &vertex, Image &image) -> void;
 auto set_pixel_rgba_depth(Vertex &vertex, Image &image) -> void;
 auto set_pixel_rgba_no_depth(Vertex &vertex, Image &image) -> void;
@@ -33,6 +76,9 @@ auto set_pixel_z_depth(Vertex &vertex, Image &image) -> void;
 auto set_pixel_z_no_depth(Vertex &vertex, Image &image) -> void;
 auto set_pixel_tex(Vertex &vertex, Image &image) -> void;
 auto set_pixel_white(Vertex &vertex, Image &image) -> void;
+auto specialize_rasterize(void (*rasterize)(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)), void (*set_pixel)(Vertex &vertex, Image &image)) -> void (*)(std::vector<Vertex> &vertices, Image &image);
+// The fetch_vertices algorithm for 16 or 32 bit indices, null when it has none.
+template <typename Index> auto specialize_fetch_vertices(void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out)) -> void (*)(std::span<const Vertex> vertices, std::span<const Index> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out);
 auto trasform_to_none(std::vector<Vertex> &vertices, const Image &image) -> void;
 auto trasform_to_viewport(std::vector<Vertex> &vertices, const Image &image) -> void;
 auto trasform_vertices_by_matrix(std::vector<Vertex> &vertices, const glm::dmat4 &matrix) -> void;
@@ -44,6 +90,7 @@ struct Pipeline {
   void (*clip_before_dehomog)(std::vector<Vertex> &vertices){Alg::clip_before_dehomog_none};
   void (*clip_fast)(std::vector<Vertex> &vertices){Alg::clip_fast_none};
   void (*dehomog)(std::vector<Vertex> &vertices){Alg::dehomog_none};
+  void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out){Alg::fetch_vertices_indexed};
   void (*rasterize)(std::vector<Vertex> &vertices, Image &image, void (*set_pixel)(Vertex &vertex, Image &image)){Alg::rasterize_none};
   void (*set_pixel)(Vertex &vertex, Image &image){Alg::set_pixel_none};
   void (*trasform_to_viewport)(std::vector<Vertex> &vertices, const Image &image){Alg::trasform_to_none};
@@ -0,0 +1,60 @@
+#include "pixel_buffer.hpp"
+
+#include <stdexcept>
+
+namespace Vis {
+PixelBufferRing::PixelBufferRing(const size_t width, const size_t height)
+    : m_width(width), m_height(height) {
+  const auto size = static_cast<GLsizeiptr>(width * height * sizeof(ColorRGBA8));
+  // Write only: the mapping is typically uncached, the rasterizer never reads it back.
+  constexpr GLbitfield flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+  glGenBuffers(static_cast<GLsizei>(buffer_count), m_buffers.data());
+  for (size_t i = 0; i < buffer_count; ++i) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[i]);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+    m_mappings[i] = static_cast<ColorRGBA8 *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    if (!m_mappings[i]) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers(static_cast<GLsizei>(buffer_count), m_buffers.data());
+      throw std::runtime_error("Failed to map pixel buffer!");
+    }
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+PixelBufferRing::~PixelBufferRing() {
+  for (size_t i = 0; i < buffer_count; ++i) {
+    if (m_fences[i]) {
+      glDeleteSync(m_fences[i]);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[i]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glDeleteBuffers(static_cast<GLsizei>(buffer_count), m_buffers.data());
+}
+
+auto PixelBufferRing::acquire() -> ColorRGBA8 * {
+  m_index = (m_index + 1) % buffer_count;
+  auto &fence = m_fences[m_index];
+  if (fence) {
+    // With three buffers in flight this only blocks when the GPU is frames behind.
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  return m_mappings[m_index];
+}
+
+auto PixelBufferRing::upload() -> void {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[m_index]);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  m_fences[m_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+[[nodiscard]] auto PixelBufferRing::get_width() const -> size_t { return m_width; }
+[[nodiscard]] auto PixelBufferRing::get_height() const -> size_t { return m_height; }
+
+} // namespace Vis
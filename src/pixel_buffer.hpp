@@ -0,0 +1,40 @@
+#pragma once
+
+#include "image.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+
+namespace Vis {
+
+// Ring of persistently mapped pixel unpack buffers. The CPU renders straight
+// into one buffer while the GPU still copies the previous ones into the
+// texture, fences keep it from writing a buffer that is still being read.
+class PixelBufferRing {
+public:
+  static constexpr size_t buffer_count{3};
+
+  PixelBufferRing(const size_t width, const size_t height);
+  ~PixelBufferRing();
+  PixelBufferRing(const PixelBufferRing &) = delete;
+  auto operator=(const PixelBufferRing &) -> PixelBufferRing & = delete;
+
+  // Waits until the GPU is done with the next buffer and returns its mapping.
+  [[nodiscard]] auto acquire() -> ColorRGBA8 *;
+  // Copies the acquired buffer into the bound texture and fences the buffer.
+  auto upload() -> void;
+
+  [[nodiscard]] auto get_width() const -> size_t;
+  [[nodiscard]] auto get_height() const -> size_t;
+
+private:
+  size_t m_width{0};
+  size_t m_height{0};
+  size_t m_index{0};
+  std::array<GLuint, buffer_count> m_buffers{};
+  std::array<ColorRGBA8 *, buffer_count> m_mappings{};
+  std::array<GLsync, buffer_count> m_fences{};
+};
+
+} // namespace Vis
@@ -0,0 +1,84 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+
+namespace Vis {
+
+Profiler::Scope::Scope(Profiler *profiler, const std::string_view name)
+    : p_profiler{profiler}, m_section{profiler ? profiler->open(name) : 0} {}
+
+Profiler::Scope::~Scope() {
+  if (p_profiler) {
+    p_profiler->close(m_section, m_timer.duration());
+  }
+}
+
+auto Profiler::begin_frame() -> void {
+  if (m_frame_count != 0) {
+    m_frame = (m_frame + 1) % frame_capacity;
+  }
+  m_frame_count = std::min(m_frame_count + 1, frame_capacity);
+  for (auto &section : m_sections) {
+    section.times[m_frame] = 0.0;
+  }
+  m_stack.clear();
+}
+
+auto Profiler::get_sections() const -> const std::vector<Section> & { return m_sections; }
+
+auto Profiler::get_frame_count() const -> size_t { return m_frame_count == 0 ? 0 : m_frame_count - 1; }
+
+auto Profiler::get_last(const Section &section) const -> double {
+  return get_frame_count() == 0 ? 0.0 : section.times[frame_index(1)];
+}
+
+auto Profiler::get_mean(const Section &section) const -> double {
+  const auto frames = get_frame_count();
+  if (frames == 0) {
+    return 0.0;
+  }
+  double sum{0.0};
+  for (size_t i = 1; i <= frames; ++i) {
+    sum += section.times[frame_index(i)];
+  }
+  return sum / static_cast<double>(frames);
+}
+
+auto Profiler::get_percentile(const Section &section, const double percentile) const -> double {
+  const auto frames = get_frame_count();
+  if (frames == 0) {
+    return 0.0;
+  }
+  std::array<double, frame_capacity> times;
+  for (size_t i = 1; i <= frames; ++i) {
+    times[i - 1] = section.times[frame_index(i)];
+  }
+  const auto rank = static_cast<size_t>(std::clamp(percentile, 0.0, 1.0) * static_cast<double>(frames - 1) + 0.5);
+  std::nth_element(times.begin(), times.begin() + static_cast<std::ptrdiff_t>(rank), times.begin() + static_cast<std::ptrdiff_t>(frames));
+  return times[rank];
+}
+
+auto Profiler::open(const std::string_view name) -> size_t {
+  const auto parent = m_stack.empty() ? no_parent : m_stack.back();
+  auto it = std::find_if(m_sections.begin(), m_sections.end(), [&](const Section &section) { return section.parent == parent && section.name == name; });
+  if (it == m_sections.end()) {
+    m_sections.push_back({std::string{name}, parent, m_stack.size()});
+    it = m_sections.end() - 1;
+  }
+  const auto section = static_cast<size_t>(it - m_sections.begin());
+  m_stack.push_back(section);
+  return section;
+}
+
+auto Profiler::close(const size_t section, const double time) -> void {
+  m_sections[section].times[m_frame] += time;
+  if (!m_stack.empty()) {
+    m_stack.pop_back();
+  }
+}
+
+auto Profiler::frame_index(const size_t frames_ago) const -> size_t {
+  return (m_frame + frame_capacity - frames_ago) % frame_capacity;
+}
+
+} // namespace Vis
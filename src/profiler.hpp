@@ -0,0 +1,62 @@
+#pragma once
+// src includes
+#include "timer.hpp"
+// std includes
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace Vis {
+// Hierarchical scoped profiler. Every distinct chain of nested scope names gets
+// a section holding its accumulated time for each of the last frame_capacity
+// frames.
+class Profiler {
+public:
+  static constexpr size_t frame_capacity{300};
+  static constexpr size_t no_parent{static_cast<size_t>(-1)};
+
+  struct Section {
+    std::string name{};
+    size_t parent{no_parent};
+    size_t depth{0};
+    std::array<double, frame_capacity> times{};
+  };
+
+  class Scope {
+  public:
+    Scope(Profiler *profiler, const std::string_view name);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    auto operator=(const Scope &) -> Scope & = delete;
+
+  private:
+    Profiler *p_profiler{nullptr};
+    size_t m_section{0};
+    Timer m_timer{};
+  };
+
+  Profiler() = default;
+  ~Profiler() = default;
+
+  auto begin_frame() -> void;
+
+  [[nodiscard]] auto get_sections() const -> const std::vector<Section> &;
+  // Number of finished frames in the ring buffer; the frame in progress is
+  // never included in the statistics below.
+  [[nodiscard]] auto get_frame_count() const -> size_t;
+  [[nodiscard]] auto get_last(const Section &section) const -> double;
+  [[nodiscard]] auto get_mean(const Section &section) const -> double;
+  [[nodiscard]] auto get_percentile(const Section &section, const double percentile) const -> double;
+
+private:
+  auto open(const std::string_view name) -> size_t;
+  auto close(const size_t section, const double time) -> void;
+  [[nodiscard]] auto frame_index(const size_t frames_ago) const -> size_t;
+
+private:
+  std::vector<Section> m_sections{};
+  std::vector<size_t> m_stack{};
+  size_t m_frame{0};
+  size_t m_frame_count{0};
+};
+} // namespace Vis
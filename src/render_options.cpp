@@ -0,0 +1,130 @@
+#include "render_options.hpp"
+
+#include <glm/ext.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace Vis {
+
+namespace {
+
+auto parse_size(const std::string_view value, const std::string_view name) -> size_t {
+  if (value.empty() || !std::all_of(value.begin(), value.end(), [](const char c) { return std::isdigit(c); })) {
+    throw std::runtime_error(std::string{name} + " argument is in wrong format!");
+  }
+  size_t result{0};
+  std::stringstream ss;
+  ss << value;
+  ss >> result;
+  if (result == 0) {
+    throw std::runtime_error(std::string{name} + " argument must be at least 1!");
+  }
+  return result;
+}
+
+auto parse_depth_format(const std::string_view value) -> DepthFormat {
+  if (value == "native") {
+    return DepthFormat::Native;
+  } else if (value == "d16") {
+    return DepthFormat::D16;
+  } else if (value == "d24") {
+    return DepthFormat::D24;
+  } else if (value == "d32f") {
+    return DepthFormat::D32F;
+  }
+  throw std::runtime_error("Depth format argument must be one of native, d16, d24, d32f!");
+}
+
+// Copies of a solid centered at `center` on a cubic lattice filling its
+// [-1, 1] cube, each scaled down to its cell.
+auto make_instances(const size_t count, const glm::dvec3 &center) -> std::vector<glm::dmat4> {
+  size_t side{1};
+  while (side * side * side < count) {
+    ++side;
+  }
+  const auto cell = 2.0 / static_cast<double>(side);
+  const auto place = [&](const size_t i) { return (static_cast<double>(i) + 0.5) * cell - 1.0; };
+  std::vector<glm::dmat4> instances{};
+  instances.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const glm::dvec3 offset{place(i % side), place(i / side % side), place(i / (side * side))};
+    instances.push_back(glm::translate(glm::dmat4{1.0}, center + offset) * glm::scale(glm::dmat4{1.0}, glm::dvec3{cell * 0.4}) * glm::translate(glm::dmat4{1.0}, -center));
+  }
+  return instances;
+}
+
+} // namespace
+
+[[nodiscard]] auto parse_render_option(const std::string_view arg, const std::function<std::string_view()> &next, HeadlessInfo &headless_info, SceneOptions &scene_options) -> bool {
+  if (arg == "-r" || arg == "--res") {
+    const auto resolution = next();
+    const auto x = resolution.find('x');
+    if (x == std::string_view::npos) {
+      throw std::runtime_error("Resolution argument is in wrong format!");
+    }
+    headless_info.width = parse_size(resolution.substr(0, x), "Resolution");
+    headless_info.height = parse_size(resolution.substr(x + 1), "Resolution");
+  } else if (arg == "-f" || arg == "--frames") {
+    headless_info.frames = parse_size(next(), "Frames");
+  } else if (arg == "-o" || arg == "--output") {
+    headless_info.output_path = next();
+  } else if (arg == "-d" || arg == "--dump") {
+    headless_info.dump_path = next();
+  } else if (arg == "-s" || arg == "--stats") {
+    headless_info.stats = true;
+  } else if (arg == "-z" || arg == "--depth-format") {
+    headless_info.depth_format = parse_depth_format(next());
+  } else if (arg == "-m" || arg == "--mesh") {
+    scene_options.mesh_path = next();
+  } else if (arg == "-g" || arg == "--generate") {
+    scene_options.generated = next();
+  } else if (arg == "-n" || arg == "--instances") {
+    scene_options.instances = parse_size(next(), "Instances");
+  } else {
+    return false;
+  }
+  return true;
+}
+
+auto print_render_options_help(std::ostream &out) -> void {
+  out << " --res, -r: sets resolution (default 800x600)\n";
+  out << " --frames, -f: number of frames to render headless (default 1)\n";
+  out << " --output, -o: writes every headless frame to <path>_<frame>.ppm and .depth\n";
+  out << " --dump, -d: writes the first frame to <path>.ppm and <path>.depth\n";
+  out << " --stats, -s: prints pipeline statistics of the last headless frame\n";
+  out << " --depth-format, -z: depth buffer format native, d16, d24 or d32f (default native)\n";
+  out << " --mesh, -m: simulates an OBJ, binary PLY or .vis mesh instead of the cube\n";
+  out << " --generate, -g: simulates a generated icosphere:<subdivisions>, grid:<cells>, torus:<sides> or cubesphere:<cells> instead of the cube\n";
+  out << " --instances, -n: draws the solid as this many instances on a lattice filling its place\n";
+}
+
+auto load_simulated_mesh(const std::string &path, SceneInfo &scene_info, MeshLoadStats *stats) -> void {
+  MeshLoadStats load_stats{};
+  auto mesh = load_mesh(path, &load_stats);
+  std::cout << "Loaded " << mesh.name << ": " << load_stats;
+  mesh.matrix = glm::translate(glm::dmat4{1.0}, glm::dvec3{scene_info.simulated_solid.matrix[3]}) * mesh.matrix;
+  scene_info.simulated_solid = std::move(mesh);
+  if (stats) {
+    *stats = load_stats;
+  }
+}
+
+auto apply_scene_options(const SceneOptions &scene_options, SceneInfo &scene_info, MeshLoadStats *mesh_stats) -> void {
+  if (!scene_options.mesh_path.empty()) {
+    load_simulated_mesh(scene_options.mesh_path, scene_info, mesh_stats);
+  } else if (!scene_options.generated.empty()) {
+    auto solid = Solid::Generate(scene_options.generated);
+    std::cout << "Generated " << solid.name << ": " << solid.get_vertices().size() << " vertices, " << solid.indices.size() / 3 << " triangles\n";
+    solid.matrix = glm::translate(glm::dmat4{1.0}, glm::dvec3{scene_info.simulated_solid.matrix[3]});
+    scene_info.simulated_solid = std::move(solid);
+  }
+  if (scene_options.instances != 0) {
+    scene_info.instances = make_instances(scene_options.instances, glm::dvec3{scene_info.simulated_solid.matrix[3]});
+  }
+}
+
+} // namespace Vis
@@ -0,0 +1,29 @@
+#pragma once
+// src includes
+#include "mesh_loader.hpp"
+#include "renderer.hpp"
+// std includes
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+namespace Vis {
+// What vis_headless and VIS --headless put into the scene besides the cube.
+struct SceneOptions {
+  std::string mesh_path{};
+  std::string generated{};
+  size_t instances{0};
+};
+
+// Parses `arg` when it is one of the rendering options shared by vis_headless
+// and VIS, reading its value through `next`. Returns false for any other
+// argument so the caller can handle its own.
+[[nodiscard]] auto parse_render_option(std::string_view arg, const std::function<std::string_view()> &next, HeadlessInfo &headless_info, SceneOptions &scene_options) -> bool;
+auto print_render_options_help(std::ostream &out) -> void;
+
+// Replaces the simulated solid with the mesh at `path`, keeping its placement.
+auto load_simulated_mesh(const std::string &path, SceneInfo &scene_info, MeshLoadStats *stats = nullptr) -> void;
+// Loads or generates the simulated solid and sets up its instances.
+auto apply_scene_options(const SceneOptions &scene_options, SceneInfo &scene_info, MeshLoadStats *mesh_stats = nullptr) -> void;
+
+} // namespace Vis
@@ -0,0 +1,465 @@
+#include "renderer.hpp"
+
+#include "timer.hpp"
+
+#include <glm/ext.hpp>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace Vis {
+
+namespace {
+
+// Corners of the object space bounding box of the solid's vertices.
+auto get_bounds(const Solid &solid) -> std::array<glm::dvec4, 8> {
+  glm::dvec3 min{std::numeric_limits<double>::max()};
+  glm::dvec3 max{std::numeric_limits<double>::lowest()};
+  for (const auto &vertex : solid.get_vertices()) {
+    const glm::dvec3 position{vertex.pos.x, vertex.pos.y, vertex.pos.z};
+    min = glm::min(min, position);
+    max = glm::max(max, position);
+  }
+  std::array<glm::dvec4, 8> corners{};
+  for (size_t i = 0; i < corners.size(); ++i) {
+    corners[i] = {i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0};
+  }
+  return corners;
+}
+
+// True when every corner lies outside the same clip plane, the planes of
+// Alg::clip_fast_triangle.
+auto is_outside_frustum(const glm::dmat4 &matrix, const std::array<glm::dvec4, 8> &corners) -> bool {
+  std::array<glm::dvec4, 8> clip{};
+  std::transform(corners.begin(), corners.end(), clip.begin(), [&](const glm::dvec4 &corner) { return matrix * corner; });
+  const auto all = [&](const auto outside) { return std::all_of(clip.begin(), clip.end(), outside); };
+  return all([](const glm::dvec4 &p) { return p.x < -p.w; }) || all([](const glm::dvec4 &p) { return p.x > p.w; }) ||
+         all([](const glm::dvec4 &p) { return p.y < -p.w; }) || all([](const glm::dvec4 &p) { return p.y > p.w; }) ||
+         all([](const glm::dvec4 &p) { return p.z < 0.0; }) || all([](const glm::dvec4 &p) { return p.z > p.w; });
+}
+
+} // namespace
+
+auto SceneInfo::Default(const size_t width, const size_t height) -> SceneInfo {
+  SceneInfo scene_info{};
+  scene_info.simulated_camera = std::make_unique<Camera>();
+  scene_info.simulated_camera->width = static_cast<double>(width);
+  scene_info.simulated_camera->height = static_cast<double>(height);
+  scene_info.simulated_camera->position = {-2.0, 0.0, 0.0};
+  scene_info.simulated_camera->near_plane = 1.0;
+  scene_info.simulated_camera->far_plane = 10.0;
+  scene_info.render_camera = std::make_unique<Camera>();
+  scene_info.render_camera->width = static_cast<double>(width);
+  scene_info.render_camera->height = static_cast<double>(height);
+  scene_info.render_camera->position = {-1.0, 0.0, 0.0};
+  scene_info.render_camera->near_plane = 0.1;
+  scene_info.render_camera->far_plane = 100.0;
+  scene_info.active_camera = scene_info.simulated_camera.get();
+  scene_info.simulated_solid.matrix = glm::translate(glm::dmat4{1.0}, {3.0, 0.0, 0.0});
+  return scene_info;
+}
+
+auto Renderer::render(std::vector<Vertex> &vertices, const Pipeline &pipeline, const glm::dmat4 &matrix, const size_t vertices_per_primitive, PipelineStats *stats) -> void {
+  const auto count = [&](StageStats &stage, const size_t in) {
+    stage.in += in / vertices_per_primitive;
+    stage.out += vertices.size() / vertices_per_primitive;
+  };
+  {
+    Profiler::Scope scope{p_profiler, "trasform_vertices"};
+    pipeline.trasform_vertices(vertices, matrix);
+  }
+  {
+    Profiler::Scope scope{p_profiler, "clip_fast"};
+    const auto in = vertices.size();
+    pipeline.clip_fast(vertices);
+    if (stats) {
+      count(stats->clip_fast, in);
+    }
+  }
+  {
+    Profiler::Scope scope{p_profiler, "clip_before_dehomog"};
+    const auto in = vertices.size();
+    pipeline.clip_before_dehomog(vertices);
+    if (stats) {
+      count(stats->clip_before_dehomog, in);
+    }
+  }
+  {
+    Profiler::Scope scope{p_profiler, "dehomog"};
+    pipeline.dehomog(vertices);
+  }
+  {
+    Profiler::Scope scope{p_profiler, "clip_after_dehomog"};
+    const auto in = vertices.size();
+    if (pipeline.clip_after_dehomog == Alg::clip_after_dehomog_guard_band) {
+      Alg::clip_to_guard_band(vertices, m_guard_band, m_guard_band_stats);
+    } else {
+      pipeline.clip_after_dehomog(vertices);
+    }
+    if (stats) {
+      count(stats->clip_after_dehomog, in);
+    }
+  }
+  {
+    Profiler::Scope scope{p_profiler, "trasform_to_viewport"};
+    pipeline.trasform_to_viewport(vertices, m_image);
+  }
+  Profiler::Scope scope{p_profiler, "rasterize"};
+  if (stats) {
+    Alg::rasterize_stats(pipeline.rasterize, vertices, m_image, pipeline.set_pixel, m_fragment_counters);
+    return;
+  }
+  if (const auto rasterize = Alg::specialize_rasterize(pipeline.rasterize, pipeline.set_pixel)) {
+    rasterize(vertices, m_image);
+    return;
+  }
+  pipeline.rasterize(vertices, m_image, pipeline.set_pixel);
+}
+
+template <typename Index> auto Renderer::fetch_indexed(void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out), std::span<const Vertex> vertices, std::span<const Index> indices, const glm::dmat4 &matrix) -> void {
+  if (const auto fetch_narrow = Alg::specialize_fetch_vertices<Index>(fetch_vertices)) {
+    fetch_narrow(vertices, indices, matrix, m_batch);
+    return;
+  }
+  m_wide_indices.assign(indices.begin(), indices.end());
+  fetch_vertices(vertices, m_wide_indices, matrix, m_batch);
+}
+
+auto Renderer::fetch_layout(const Layout &layout, const Solid &solid, void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out), const size_t index_count, const glm::dmat4 &matrix) -> void {
+  Profiler::Scope scope{p_profiler, "fetch_vertices"};
+  switch (solid.indices.get_format()) {
+  case IndexFormat::UInt16: {
+    fetch_indexed(fetch_vertices, solid.get_vertices(), solid.indices.get_indices<uint16_t>().subspan(layout.start, index_count), matrix);
+  } break;
+  case IndexFormat::UInt32: {
+    fetch_indexed(fetch_vertices, solid.get_vertices(), solid.indices.get_indices<uint32_t>().subspan(layout.start, index_count), matrix);
+  } break;
+  }
+}
+
+template <typename Index> auto Renderer::compact_instance_mesh(std::span<const Vertex> vertices, std::span<const Index> indices) -> void {
+  constexpr auto unused = std::numeric_limits<uint32_t>::max();
+  m_instance_remap.assign(vertices.size(), unused);
+  m_instance_vertices.clear();
+  m_instance_indices.clear();
+  m_instance_indices.reserve(indices.size());
+  for (const auto index : indices) {
+    auto &local = m_instance_remap[index];
+    if (local == unused) {
+      local = static_cast<uint32_t>(m_instance_vertices.size());
+      m_instance_vertices.push_back(vertices[index]);
+    }
+    m_instance_indices.push_back(local);
+  }
+}
+
+template <size_t vertices_per_primitie> auto Renderer::render_instanced_topology(const Layout &layout, const Solid &solid, const Pipeline &pipeline) -> void {
+  const auto index_count = layout.count * vertices_per_primitie;
+  if (index_count == 0) {
+    return;
+  }
+  // Every instance transforms only the layout's unique vertices and gathers
+  // them through its indices. No culling fetch such as fetch_triangles_by_stream
+  // sees the untransformed vertices, clip_fast culls each instance instead.
+  {
+    Profiler::Scope scope{p_profiler, "fetch_vertices"};
+    switch (solid.indices.get_format()) {
+    case IndexFormat::UInt16: {
+      compact_instance_mesh(solid.get_vertices(), solid.indices.get_indices<uint16_t>().subspan(layout.start, index_count));
+    } break;
+    case IndexFormat::UInt32: {
+      compact_instance_mesh(solid.get_vertices(), solid.indices.get_indices<uint32_t>().subspan(layout.start, index_count));
+    } break;
+    }
+  }
+  const auto instances_per_batch = std::max<size_t>(1, instance_batch_vertices / index_count);
+  PipelineStats *stats = m_stats_enabled ? &m_stats : nullptr;
+  for (size_t first = 0; first < m_instance_matrices.size(); first += instances_per_batch) {
+    const auto last = std::min(first + instances_per_batch, m_instance_matrices.size());
+    {
+      Profiler::Scope scope{p_profiler, "trasform_instances"};
+      m_batch.clear();
+      m_batch.reserve((last - first) * index_count);
+      m_instance_transformed.resize(m_instance_vertices.size());
+      for (size_t instance = first; instance < last; ++instance) {
+        const Mat4 transform{m_instance_matrices[instance]};
+        for (size_t i = 0; i < m_instance_vertices.size(); ++i) {
+          m_instance_transformed[i] = m_instance_vertices[i];
+          m_instance_transformed[i].pos = transform * m_instance_vertices[i].pos;
+        }
+        for (const auto index : m_instance_indices) {
+          m_batch.push_back(m_instance_transformed[index]);
+        }
+      }
+    }
+    if (stats) {
+      stats->vertices += (last - first) * index_count;
+      stats->primitives += (last - first) * layout.count;
+    }
+    render(m_batch, pipeline, glm::dmat4{1.0}, vertices_per_primitie, stats);
+  }
+}
+
+template <size_t vertices_per_primitie, AddToNewSolid add_to_new_solid> auto Renderer::render_topology(const Layout &layout, const Solid &solid, const Pipeline &pipeline, const glm::dmat4 &matrix, Solid *new_solid) -> void {
+  const auto index_count = layout.count * vertices_per_primitie;
+  fetch_layout(layout, solid, pipeline.fetch_vertices, index_count, matrix);
+  PipelineStats *stats = add_to_new_solid == AddToNewSolid::False && m_stats_enabled ? &m_stats : nullptr;
+  if (stats) {
+    stats->vertices += index_count;
+    stats->primitives += layout.count;
+  }
+  render(m_batch, pipeline, matrix, vertices_per_primitie, stats);
+  if constexpr (add_to_new_solid == AddToNewSolid::True) {
+    if (m_batch.size() % vertices_per_primitie != 0) {
+      return;
+    }
+    if (new_solid->layout.empty() || new_solid->layout.back().topology != layout.topology) {
+      new_solid->layout.push_back({layout.topology, new_solid->indices.size(), 0});
+    }
+    const size_t new_size = new_solid->vertices.size() + m_batch.size();
+    new_solid->vertices.reserve(new_size);
+    new_solid->indices.reserve(new_size);
+    for (const auto &vertex : m_batch) {
+      new_solid->vertices.push_back(vertex);
+      new_solid->indices.push_back(new_solid->indices.size());
+    }
+    new_solid->layout.back().count += m_batch.size() / vertices_per_primitie;
+  }
+}
+
+auto Renderer::simulate_solid(const SceneInfo &scene_info, const Solid &solid) -> Solid {
+  auto matrix = scene_info.simulated_camera->get_projection() * scene_info.simulated_camera->get_view() * scene_info.simulated_model_matrix * solid.matrix;
+  Solid new_solid;
+  new_solid.name = solid.name;
+  new_solid.matrix = glm::dmat4{1.0};
+  for (const auto layout : solid.layout) {
+    switch (layout.topology) {
+    case Topology::Point: {
+      render_topology<1, AddToNewSolid::True>(layout, solid, scene_info.simulate_point_pipeline, matrix, &new_solid);
+    } break;
+    case Topology::Line: {
+      render_topology<2, AddToNewSolid::True>(layout, solid, scene_info.simulate_line_pipeline, matrix, &new_solid);
+    } break;
+    case Topology::Triangle: {
+      render_topology<3, AddToNewSolid::True>(layout, solid, scene_info.simulate_triangle_pipeline, matrix, &new_solid);
+    } break;
+    }
+  }
+  return new_solid;
+}
+
+auto get_camera_model(const Camera &camera) -> Solid {
+  Solid solid{};
+  solid.name = "";
+  solid.matrix = glm::dmat4{1.0};
+  solid.vertices.reserve(9);
+  glm::dvec4 color = {1.0, 1.0, 1.0, 1.0};
+  Vertex v1{};
+  v1.pos = {camera.position.x, camera.position.y, camera.position.z, 1.0};
+  v1.col = color;
+  solid.vertices.push_back(v1);
+  std::array<Vertex, 8> vertices{};
+  vertices[0].pos = {-1.0, -1.0, 0.0, 1.0};
+  vertices[1].pos = {1.0, -1.0, 0.0, 1.0};
+  vertices[2].pos = {-1.0, 1.0, 0.0, 1.0};
+  vertices[3].pos = {1.0, 1.0, 0.0, 1.0};
+  vertices[4].pos = {-1.0, -1.0, 1.0, 1.0};
+  vertices[5].pos = {1.0, -1.0, 1.0, 1.0};
+  vertices[6].pos = {-1.0, 1.0, 1.0, 1.0};
+  vertices[7].pos = {1.0, 1.0, 1.0, 1.0};
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    vertices[i].col = color;
+    vertices[i].pos = Mat4{glm::inverse(camera.get_view()) * glm::inverse(camera.get_projection())} * vertices[i].pos;
+    solid.vertices.push_back(vertices[i]);
+  }
+  solid.indices = {0, 5, 0, 6, 0, 7, 0, 8, 1, 2, 2, 4, 4, 3, 3, 1, 5, 6, 6, 8, 8, 7, 7, 5};
+  solid.layout.push_back({Topology::Line, 0, 12});
+  return solid;
+};
+
+auto Renderer::render_solid(const SceneInfo &scene_info, const Solid &solid) -> void {
+  auto matrix = scene_info.active_camera->get_projection() * scene_info.active_camera->get_view() * scene_info.model_matrix * solid.matrix;
+  for (const auto layout : solid.layout) {
+    switch (layout.topology) {
+    case Topology::Point: {
+      render_topology<1, AddToNewSolid::False>(layout, solid, scene_info.render_point_pipeline, matrix);
+    } break;
+    case Topology::Line: {
+      render_topology<2, AddToNewSolid::False>(layout, solid, scene_info.render_line_pipeline, matrix);
+    } break;
+    case Topology::Triangle: {
+      render_topology<3, AddToNewSolid::False>(layout, solid, scene_info.render_triangle_pipeline, matrix);
+    } break;
+    }
+  }
+}
+
+auto Renderer::render_instances(const SceneInfo &scene_info, const Solid &solid, std::span<const glm::dmat4> instances) -> void {
+  const auto matrix = scene_info.active_camera->get_projection() * scene_info.active_camera->get_view() * scene_info.model_matrix;
+  const auto bounds = get_bounds(solid);
+  m_instance_matrices.clear();
+  {
+    Profiler::Scope scope{p_profiler, "cull_instances"};
+    for (const auto &instance : instances) {
+      const glm::dmat4 instance_matrix = matrix * instance * solid.matrix;
+      if (!is_outside_frustum(instance_matrix, bounds)) {
+        m_instance_matrices.push_back(instance_matrix);
+      }
+    }
+  }
+  if (m_stats_enabled) {
+    m_stats.instances += instances.size();
+    m_stats.instances_culled += instances.size() - m_instance_matrices.size();
+  }
+  if (m_instance_matrices.empty()) {
+    return;
+  }
+  for (const auto layout : solid.layout) {
+    switch (layout.topology) {
+    case Topology::Point: {
+      render_instanced_topology<1>(layout, solid, scene_info.render_point_pipeline);
+    } break;
+    case Topology::Line: {
+      render_instanced_topology<2>(layout, solid, scene_info.render_line_pipeline);
+    } break;
+    case Topology::Triangle: {
+      render_instanced_topology<3>(layout, solid, scene_info.render_triangle_pipeline);
+    } break;
+    }
+  }
+}
+
+auto Renderer::render_image(SceneInfo &scene_info, const size_t width, const size_t height) -> void {
+  if (width != m_image.get_width() || height != m_image.get_height()) {
+    m_image.resize(width, height);
+    scene_info.active_camera->width = static_cast<double>(width);
+    scene_info.active_camera->height = static_cast<double>(height);
+  }
+  {
+    Profiler::Scope scope{p_profiler, "clear"};
+    m_image.clear({0.05, 0.05, 0.05, 1.0});
+  }
+  m_guard_band_stats = {};
+  m_image.reset_hiz_stats();
+  if (m_stats_enabled) {
+    m_stats = {};
+    Alg::begin_fragment_stats(m_fragment_counters, m_image);
+  }
+  if (scene_info.simulate) {
+    Solid simulated = simulate_solid(scene_info, scene_info.simulated_solid);
+    glm::dmat4 scene_matrix = {1.0};
+    Solid camera_solid = get_camera_model(*scene_info.simulated_camera.get());
+    switch (scene_info.scene_space) {
+    case SceneSpace::SolidModel: {
+      simulated.matrix = glm::dmat4{glm::inverse(scene_info.simulated_solid.matrix) * glm::inverse(scene_info.simulated_camera->get_view()) * glm::inverse(scene_info.simulated_camera->get_projection())};
+    } break;
+    case SceneSpace::SceneModel: {
+      simulated.matrix = glm::dmat4{glm::inverse(scene_info.simulated_camera->get_view()) * glm::inverse(scene_info.simulated_camera->get_projection())};
+    } break;
+    case SceneSpace::View: {
+      simulated.matrix = glm::dmat4{glm::inverse(scene_info.simulated_camera->get_projection())};
+      scene_matrix = {0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+      camera_solid.matrix = scene_info.simulated_camera->get_view();
+    } break;
+    case SceneSpace::Projection: {
+      scene_matrix = {0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+      camera_solid.indices.set(0, 1);
+      camera_solid.indices.set(2, 2);
+      camera_solid.indices.set(4, 3);
+      camera_solid.indices.set(6, 4);
+      camera_solid.matrix = scene_info.simulated_camera->get_projection() * scene_info.simulated_camera->get_view();
+    } break;
+    }
+    std::swap(scene_matrix, scene_info.model_matrix);
+    render_solid(scene_info, simulated);
+    if (scene_info.scene_space != SceneSpace::SolidModel) {
+      render_solid(scene_info, camera_solid);
+    }
+    if (scene_info.render_axis) {
+      render_solid(scene_info, Solid::Axis());
+    }
+    std::swap(scene_matrix, scene_info.model_matrix);
+  } else if (scene_info.instances.empty()) {
+    render_solid(scene_info, scene_info.simulated_solid);
+  } else {
+    render_instances(scene_info, scene_info.simulated_solid, scene_info.instances);
+  }
+  if (m_stats_enabled) {
+    m_stats.fragment = Alg::get_fragment_stats(m_fragment_counters);
+    m_stats.hiz = m_image.get_hiz_stats();
+  }
+  {
+    Profiler::Scope scope{p_profiler, "resolve"};
+    m_image.resolve();
+  }
+}
+
+auto Renderer::render_frames(SceneInfo &scene_info, const HeadlessInfo &headless_info) -> double {
+  double total_time{0.0};
+  set_stats_enabled(headless_info.stats);
+  m_image.set_depth_format(headless_info.depth_format);
+  for (size_t frame = 0; frame < headless_info.frames; ++frame) {
+    double frame_time{0.0};
+    {
+      Timer timer(&frame_time);
+      render_image(scene_info, headless_info.width, headless_info.height);
+    }
+    total_time += frame_time;
+    if (frame == 0 && !headless_info.dump_path.empty()) {
+      m_image.save(headless_info.dump_path);
+    }
+    if (!headless_info.output_path.empty()) {
+      std::stringstream ss;
+      ss << headless_info.output_path << '_' << std::setw(4) << std::setfill('0') << frame;
+      m_image.save(ss.str());
+    }
+  }
+  return total_time;
+}
+
+auto Renderer::get_image() -> Image & { return m_image; }
+
+auto Renderer::get_image() const -> const Image & { return m_image; }
+
+auto Renderer::set_profiler(Profiler *profiler) -> void { p_profiler = profiler; }
+
+auto Renderer::set_stats_enabled(const bool enabled) -> void { m_stats_enabled = enabled; }
+
+auto Renderer::get_stats_enabled() const -> bool { return m_stats_enabled; }
+
+auto Renderer::get_stats() const -> const PipelineStats & { return m_stats; }
+
+auto Renderer::set_guard_band(const Real guard_band) -> void { m_guard_band = std::max(guard_band, Real{1}); }
+
+auto Renderer::get_guard_band() const -> Real { return m_guard_band; }
+
+auto Renderer::get_guard_band_stats() const -> const GuardBandStats & { return m_guard_band_stats; }
+
+auto PipelineStats::overdraw() const -> double {
+  return fragment.pixels_covered == 0 ? 0.0 : static_cast<double>(fragment.fragments) / static_cast<double>(fragment.pixels_covered);
+}
+
+auto operator<<(std::ostream &out, const PipelineStats &stats) -> std::ostream & {
+  out << "vertices: " << stats.vertices << '\n';
+  out << "primitives: " << stats.primitives << '\n';
+  out << "instances: " << stats.instances << " (" << stats.instances_culled << " culled)\n";
+  out << "clip_fast: " << stats.clip_fast.in << " -> " << stats.clip_fast.out << '\n';
+  out << "clip_before_dehomog: " << stats.clip_before_dehomog.in << " -> " << stats.clip_before_dehomog.out << '\n';
+  out << "clip_after_dehomog: " << stats.clip_after_dehomog.in << " -> " << stats.clip_after_dehomog.out << '\n';
+  out << "fragments: " << stats.fragment.fragments << '\n';
+  out << "depth passed: " << stats.fragment.depth_passed << '\n';
+  out << "depth failed: " << stats.fragment.depth_failed << '\n';
+  out << "discarded: " << stats.fragment.discarded << '\n';
+  out << "pixels covered: " << stats.fragment.pixels_covered << '\n';
+  out << "overdraw: " << stats.overdraw() << '\n';
+  out << "hiz triangles rejected: " << stats.hiz.triangles_rejected << " / " << stats.hiz.triangles_tested << '\n';
+  out << "hiz spans rejected: " << stats.hiz.spans_rejected << '\n';
+  out << "hiz pixels rejected: " << stats.hiz.pixels_rejected << '\n';
+  return out;
+}
+
+} // namespace Vis
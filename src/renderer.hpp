@@ -0,0 +1,199 @@
+#pragma once
+// src includes
+#include "camera.hpp"
+#include "image.hpp"
+#include "pipeline.hpp"
+#include "profiler.hpp"
+#include "solid.hpp"
+// std includes
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+namespace Vis {
+enum class SceneSpace { SolidModel, SceneModel, View, Projection };
+enum class AddToNewSolid { False, True };
+struct SceneInfo {
+  Solid simulated_solid{Solid::Cube()};
+  SceneSpace scene_space{SceneSpace::SceneModel};
+  bool render_axis{true};
+  bool render_grid{false};
+  bool simulate{false};
+  glm::dmat4 model_matrix{1.0};
+  glm::dmat4 simulated_model_matrix{1.0};
+  // Transforms of the copies of simulated_solid drawn when not simulating,
+  // applied between model_matrix and the solid's matrix. Empty draws it once.
+  std::vector<glm::dmat4> instances{};
+  std::unique_ptr<Camera> render_camera{nullptr};
+  std::unique_ptr<Camera> simulated_camera{nullptr};
+  Camera *active_camera{nullptr};
+  Pipeline render_triangle_pipeline{
+      .clip_after_dehomog = Alg::clip_after_dehomog_triangle,
+      .clip_backface = Alg::clip_backface_triangle,
+      .clip_before_dehomog = Alg::clip_before_dehomog_triangle,
+      .clip_fast = Alg::clip_fast_triangle,
+      .dehomog = Alg::dehomog_all,
+      .fetch_vertices = Alg::fetch_vertices_by_matrix,
+      .rasterize = Alg::rasterize_triangle,
+      .set_pixel = Alg::set_pixel_rgba_depth,
+      .trasform_to_viewport = Alg::trasform_to_viewport,
+      .trasform_vertices = Alg::trasform_vertices_by_none,
+  };
+  Pipeline render_line_pipeline{
+      .clip_after_dehomog = Alg::clip_after_dehomog_line,
+      .clip_before_dehomog = Alg::clip_before_dehomog_line,
+      .clip_fast = Alg::clip_fast_line,
+      .dehomog = Alg::dehomog_all,
+      .fetch_vertices = Alg::fetch_vertices_by_matrix,
+      .rasterize = Alg::rasterize_line,
+      .set_pixel = Alg::set_pixel_rgba_depth,
+      .trasform_to_viewport = Alg::trasform_to_viewport,
+      .trasform_vertices = Alg::trasform_vertices_by_none,
+  };
+  Pipeline render_point_pipeline{
+      .clip_after_dehomog = Alg::clip_after_dehomog_none,
+      .clip_before_dehomog = Alg::clip_before_dehomog_none,
+      .clip_fast = Alg::clip_fast_point,
+      .dehomog = Alg::dehomog_all,
+      .fetch_vertices = Alg::fetch_vertices_by_matrix,
+      .rasterize = Alg::rasterize_point,
+      .set_pixel = Alg::set_pixel_rgba_depth,
+      .trasform_to_viewport = Alg::trasform_to_viewport,
+      .trasform_vertices = Alg::trasform_vertices_by_none,
+  };
+  Pipeline simulate_triangle_pipeline{
+      .clip_after_dehomog = Alg::clip_after_dehomog_triangle,
+      .clip_before_dehomog = Alg::clip_before_dehomog_triangle,
+      .clip_fast = Alg::clip_fast_triangle,
+      .dehomog = Alg::dehomog_all,
+      .fetch_vertices = Alg::fetch_vertices_by_matrix,
+      .rasterize = Alg::rasterize_none,
+      .set_pixel = Alg::set_pixel_none,
+      .trasform_to_viewport = Alg::trasform_to_none,
+      .trasform_vertices = Alg::trasform_vertices_by_none,
+  };
+  Pipeline simulate_line_pipeline{};
+  Pipeline simulate_point_pipeline{};
+
+  static auto Default(const size_t width, const size_t height) -> SceneInfo;
+};
+
+struct StageStats {
+  size_t in{0};
+  size_t out{0};
+};
+
+// Per frame counters in the spirit of GL pipeline statistics queries. Stage
+// counts are primitives, the simulated camera pass is not included.
+struct PipelineStats {
+  size_t vertices{0};
+  size_t primitives{0};
+  size_t instances{0};
+  size_t instances_culled{0};
+  StageStats clip_fast{};
+  StageStats clip_before_dehomog{};
+  StageStats clip_after_dehomog{};
+  FragmentStats fragment{};
+  HiZStats hiz{};
+
+  // Rasterized fragments per covered pixel.
+  [[nodiscard]] auto overdraw() const -> double;
+};
+
+auto operator<<(std::ostream &out, const PipelineStats &stats) -> std::ostream &;
+
+struct HeadlessInfo {
+  size_t width{800};
+  size_t height{600};
+  size_t frames{1};
+  std::string output_path{};
+  std::string dump_path{};
+  bool stats{false};
+  DepthFormat depth_format{DepthFormat::Native};
+};
+
+// Renders a SceneInfo into an Image with the software pipeline. It does not
+// touch GLFW, OpenGL or ImGui, so it can run without a display.
+class Renderer {
+public:
+  Renderer() = default;
+  ~Renderer() = default;
+
+  auto render_image(SceneInfo &scene_info, const size_t width, const size_t height) -> void;
+  // Renders `frames` images, writing them to disk when paths are set, and
+  // returns the total render time in seconds.
+  auto render_frames(SceneInfo &scene_info, const HeadlessInfo &headless_info) -> double;
+
+  [[nodiscard]] auto get_image() -> Image &;
+  [[nodiscard]] auto get_image() const -> const Image &;
+  // Pipeline stages are recorded into `profiler` when it is not null.
+  auto set_profiler(Profiler *profiler) -> void;
+  // Statistics cost nothing while disabled; enabled, every fragment goes
+  // through Alg::rasterize_stats instead of a specialized rasterizer.
+  auto set_stats_enabled(const bool enabled) -> void;
+  [[nodiscard]] auto get_stats_enabled() const -> bool;
+  [[nodiscard]] auto get_stats() const -> const PipelineStats &;
+  // Guard band used where a pipeline clips with clip_after_dehomog_guard_band,
+  // and what it did with the last frame's triangles.
+  auto set_guard_band(const Real guard_band) -> void;
+  [[nodiscard]] auto get_guard_band() const -> Real;
+  [[nodiscard]] auto get_guard_band_stats() const -> const GuardBandStats &;
+
+private:
+  // Vertices of one batch of instances sent through the pipeline together.
+  static constexpr size_t instance_batch_vertices{3 * 4096};
+
+  auto render_solid(const SceneInfo &scene_info, const Solid &solid) -> void;
+  // Draws `solid` once per instance transform. Each layout's unique vertices
+  // are collected once, instances whose bounding box is outside the frustum
+  // are culled and the rest are transformed and gathered into shared batches.
+  auto render_instances(const SceneInfo &scene_info, const Solid &solid,
+                        std::span<const glm::dmat4> instances) -> void;
+  auto render(std::vector<Vertex> &vertices, const Pipeline &pipeline,
+              const glm::dmat4 &matrix, const size_t vertices_per_primitive,
+              PipelineStats *stats) -> void;
+  [[nodiscard]] auto simulate_solid(const SceneInfo &scene_info, const Solid &solid) -> Solid;
+  // Uses the variant of `fetch_vertices` for Index directly, or widens the
+  // indices for fetch functions without a narrow variant.
+  template <typename Index>
+  auto fetch_indexed(void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out),
+                     std::span<const Vertex> vertices, std::span<const Index> indices,
+                     const glm::dmat4 &matrix) -> void;
+  auto fetch_layout(const Layout &layout, const Solid &solid,
+                    void (*fetch_vertices)(std::span<const Vertex> vertices, std::span<const size_t> indices, const glm::dmat4 &matrix, std::vector<Vertex> &out),
+                    const size_t index_count, const glm::dmat4 &matrix) -> void;
+  // Copies the vertices `indices` reference into m_instance_vertices and
+  // renumbers the indices into m_instance_indices.
+  template <typename Index>
+  auto compact_instance_mesh(std::span<const Vertex> vertices,
+                             std::span<const Index> indices) -> void;
+  template <size_t vertices_per_primitie>
+  auto render_instanced_topology(const Layout &layout, const Solid &solid,
+                                 const Pipeline &pipeline) -> void;
+  template <size_t vertices_per_primitie, AddToNewSolid add_to_new_solid>
+  auto render_topology(const Layout &layout, const Solid &solid,
+                       const Pipeline &pipeline, const glm::dmat4 &matrix,
+                       Solid *new_solid = nullptr) -> void;
+
+private:
+  Image m_image{};
+  std::vector<Vertex> m_batch{};
+  std::vector<size_t> m_wide_indices{};
+  // Unique object space vertices of the layout being instanced, the indices
+  // into them and one instance's transformed copy.
+  std::vector<Vertex> m_instance_vertices{};
+  std::vector<uint32_t> m_instance_indices{};
+  std::vector<Vertex> m_instance_transformed{};
+  std::vector<uint32_t> m_instance_remap{};
+  // Clip matrices of the instances that passed culling.
+  std::vector<glm::dmat4> m_instance_matrices{};
+  Profiler *p_profiler{nullptr};
+  bool m_stats_enabled{false};
+  PipelineStats m_stats{};
+  FragmentCounters m_fragment_counters{};
+  Real m_guard_band{default_guard_band};
+  GuardBandStats m_guard_band_stats{};
+};
+
+} // namespace Vis
@@ -1,5 +1,38 @@
 #include "solid.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 namespace Vis {
+namespace {
+auto surface_vertex(const glm::dvec3 &position, const glm::dvec3 &normal, const glm::dvec2 &uv) -> Vertex {
+  return {Vec4{glm::dvec4{position, 1.0}}, Vec4{glm::dvec4{normal * 0.5 + 0.5, 1.0}}, Vec2{uv}};
+}
+auto sphere_vertex(const glm::dvec3 &position) -> Vertex {
+  const auto uv = glm::dvec2{std::atan2(position.z, position.x) / (2.0 * std::numbers::pi) + 0.5,
+                             std::asin(std::clamp(position.y, -1.0, 1.0)) / std::numbers::pi + 0.5};
+  return surface_vertex(position, position, uv);
+}
+auto generated_solid(const std::string_view name, std::vector<Vertex> &&vertices, const std::vector<uint32_t> &triangles) -> Solid {
+  IndexBuffer indices{IndexBuffer::format_for(vertices.size())};
+  indices.append(triangles);
+  return {{name.data()}, std::move(vertices), std::move(indices), {{Topology::Triangle, 0, triangles.size() / 3}}, {1.0}};
+}
+auto check_vertex_count(const size_t count) -> void {
+  if (count > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Generated solid with " + std::to_string(count) + " vertices does not fit 32 bit indices!");
+  }
+}
+} // namespace
+auto Solid::get_vertices() const -> std::span<const Vertex> {
+  return mapped_vertices.empty() ? std::span<const Vertex>{vertices} : mapped_vertices;
+}
 auto Solid::Cube(const std::string_view name) -> Solid {
   return {{name.data()},
           {Vertex({-1.0, -1.0, -1.0, 1.0}, {0.0, 0.0, 0.0, 1.0}),
@@ -147,4 +180,194 @@ auto Solid::Icosphere(const std::string_view name) -> Solid {
     {{Topology::Triangle, 0, 80}},
     {1.0}};
 }
+auto Solid::Icosphere(const size_t subdivisions, const std::string_view name) -> Solid {
+  const auto t = (1.0 + std::sqrt(5.0)) / 2.0;
+  std::vector<glm::dvec3> positions{{-1.0, t, 0.0}, {1.0, t, 0.0}, {-1.0, -t, 0.0}, {1.0, -t, 0.0},
+                                    {0.0, -1.0, t}, {0.0, 1.0, t}, {0.0, -1.0, -t}, {0.0, 1.0, -t},
+                                    {t, 0.0, -1.0}, {t, 0.0, 1.0}, {-t, 0.0, -1.0}, {-t, 0.0, 1.0}};
+  std::vector<uint32_t> triangles{0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+                                  1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+                                  3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+                                  4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+  for (auto &position : positions) {
+    position = glm::normalize(position);
+  }
+  // Every level splits each triangle in four. Neighbours share the new vertex
+  // of their common edge, found by the edge's vertex pair.
+  for (size_t level = 0; level < subdivisions; ++level) {
+    // A closed triangle mesh has 3 / 2 edges per triangle, each adds a vertex.
+    check_vertex_count(positions.size() + triangles.size() / 2);
+    std::unordered_map<uint64_t, uint32_t> midpoints{};
+    midpoints.reserve(triangles.size() / 2);
+    positions.reserve(positions.size() + triangles.size() / 2);
+    const auto midpoint = [&](const uint32_t a, const uint32_t b) {
+      const auto key = (uint64_t{std::min(a, b)} << 32) | std::max(a, b);
+      const auto [it, inserted] = midpoints.try_emplace(key, static_cast<uint32_t>(positions.size()));
+      if (inserted) {
+        positions.push_back(glm::normalize(positions[a] + positions[b]));
+      }
+      return it->second;
+    };
+    std::vector<uint32_t> subdivided{};
+    subdivided.reserve(triangles.size() * 4);
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+      const auto a = triangles[i];
+      const auto b = triangles[i + 1];
+      const auto c = triangles[i + 2];
+      const auto ab = midpoint(a, b);
+      const auto bc = midpoint(b, c);
+      const auto ca = midpoint(c, a);
+      subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+    }
+    triangles = std::move(subdivided);
+  }
+  std::vector<Vertex> vertices{};
+  vertices.reserve(positions.size());
+  for (const auto &position : positions) {
+    vertices.push_back(sphere_vertex(position));
+  }
+  return generated_solid(name, std::move(vertices), triangles);
+}
+auto Solid::Grid(const size_t columns, const size_t rows, const std::string_view name) -> Solid {
+  if (columns == 0 || rows == 0) {
+    throw std::runtime_error("Grid needs at least one column and one row!");
+  }
+  check_vertex_count((columns + 1) * (rows + 1));
+  std::vector<Vertex> vertices{};
+  vertices.reserve((columns + 1) * (rows + 1));
+  for (size_t row = 0; row <= rows; ++row) {
+    for (size_t column = 0; column <= columns; ++column) {
+      const auto uv = glm::dvec2{static_cast<double>(column) / static_cast<double>(columns),
+                                 static_cast<double>(row) / static_cast<double>(rows)};
+      vertices.push_back({Vec4{glm::dvec4{0.0, uv.x * 2.0 - 1.0, uv.y * 2.0 - 1.0, 1.0}}, Vec4{glm::dvec4{uv.x, uv.y, 0.0, 1.0}}, Vec2{uv}});
+    }
+  }
+  // Same winding as Square, facing -x.
+  std::vector<uint32_t> triangles{};
+  triangles.reserve(columns * rows * 6);
+  for (size_t row = 0; row < rows; ++row) {
+    for (size_t column = 0; column < columns; ++column) {
+      const auto a = static_cast<uint32_t>(column + row * (columns + 1));
+      const auto b = a + 1;
+      const auto c = static_cast<uint32_t>(a + columns + 1);
+      const auto d = c + 1;
+      triangles.insert(triangles.end(), {a, c, b, d, b, c});
+    }
+  }
+  return generated_solid(name, std::move(vertices), triangles);
+}
+auto Solid::Torus(const size_t rings, const size_t sides, const std::string_view name) -> Solid {
+  if (rings < 3 || sides < 3) {
+    throw std::runtime_error("Torus needs at least 3 rings and 3 sides!");
+  }
+  check_vertex_count(rings * sides);
+  constexpr auto major_radius = 0.7;
+  constexpr auto minor_radius = 0.3;
+  // Rings go around the x axis. The seams share their vertices, so only the
+  // texture coordinates wrap back to 0 there.
+  std::vector<Vertex> vertices{};
+  vertices.reserve(rings * sides);
+  for (size_t ring = 0; ring < rings; ++ring) {
+    const auto u = static_cast<double>(ring) / static_cast<double>(rings);
+    const auto theta = u * 2.0 * std::numbers::pi;
+    const auto center = glm::dvec3{0.0, std::cos(theta), std::sin(theta)} * major_radius;
+    for (size_t side = 0; side < sides; ++side) {
+      const auto v = static_cast<double>(side) / static_cast<double>(sides);
+      const auto phi = v * 2.0 * std::numbers::pi;
+      const auto normal = glm::dvec3{std::sin(phi), std::cos(phi) * std::cos(theta), std::cos(phi) * std::sin(theta)};
+      vertices.push_back(surface_vertex(center + normal * minor_radius, normal, {u, v}));
+    }
+  }
+  std::vector<uint32_t> triangles{};
+  triangles.reserve(rings * sides * 6);
+  for (size_t ring = 0; ring < rings; ++ring) {
+    for (size_t side = 0; side < sides; ++side) {
+      const auto a = static_cast<uint32_t>(side + ring * sides);
+      const auto b = static_cast<uint32_t>(side + ((ring + 1) % rings) * sides);
+      const auto c = static_cast<uint32_t>((side + 1) % sides + ring * sides);
+      const auto d = static_cast<uint32_t>((side + 1) % sides + ((ring + 1) % rings) * sides);
+      triangles.insert(triangles.end(), {a, b, d, a, d, c});
+    }
+  }
+  return generated_solid(name, std::move(vertices), triangles);
+}
+auto Solid::CubeSphere(const size_t subdivisions, const std::string_view name) -> Solid {
+  if (subdivisions == 0) {
+    throw std::runtime_error("CubeSphere needs at least one subdivision!");
+  }
+  const auto n = subdivisions;
+  check_vertex_count(6 * n * n + 2);
+  // Each face is an n by n grid on the surface of the [0, n] lattice cube,
+  // edge and corner points are shared between faces through their lattice
+  // coordinates. u cross v is the outward normal of the face.
+  struct Face {
+    int axis;
+    int u;
+    int v;
+    bool positive;
+  };
+  constexpr std::array<Face, 6> faces{{{0, 1, 2, true}, {0, 2, 1, false}, {1, 2, 0, true},
+                                       {1, 0, 2, false}, {2, 0, 1, true}, {2, 1, 0, false}}};
+  std::vector<Vertex> vertices{};
+  vertices.reserve(6 * n * n + 2);
+  std::unordered_map<uint64_t, uint32_t> lattice{};
+  lattice.reserve(6 * n * n + 2);
+  const auto vertex = [&](const std::array<size_t, 3> &point) {
+    const auto key = (uint64_t{point[0]} * (n + 1) + point[1]) * (n + 1) + point[2];
+    const auto [it, inserted] = lattice.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+    if (inserted) {
+      const auto cube = glm::dvec3{static_cast<double>(point[0]), static_cast<double>(point[1]), static_cast<double>(point[2])} * (2.0 / static_cast<double>(n)) - 1.0;
+      vertices.push_back(sphere_vertex(glm::normalize(cube)));
+    }
+    return it->second;
+  };
+  std::vector<uint32_t> triangles{};
+  triangles.reserve(6 * n * n * 6);
+  for (const auto &face : faces) {
+    std::array<size_t, 3> point{};
+    point[face.axis] = face.positive ? n : 0;
+    const auto corner = [&](const size_t u, const size_t v) {
+      point[face.u] = u;
+      point[face.v] = v;
+      return vertex(point);
+    };
+    for (size_t v = 0; v < n; ++v) {
+      for (size_t u = 0; u < n; ++u) {
+        const auto a = corner(u, v);
+        const auto b = corner(u + 1, v);
+        const auto c = corner(u + 1, v + 1);
+        const auto d = corner(u, v + 1);
+        triangles.insert(triangles.end(), {a, b, c, a, c, d});
+      }
+    }
+  }
+  return generated_solid(name, std::move(vertices), triangles);
+}
+auto Solid::Generate(const std::string_view description) -> Solid {
+  const auto separator = description.find(':');
+  const auto kind = description.substr(0, separator);
+  size_t level{0};
+  if (separator != std::string_view::npos) {
+    const auto value = description.substr(separator + 1);
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), level);
+    if (error != std::errc{} || end != value.data() + value.size()) {
+      throw std::runtime_error("Invalid level in generated solid '" + std::string{description} + "'!");
+    }
+  }
+  const auto level_or = [&](const size_t fallback) { return separator == std::string_view::npos ? fallback : level; };
+  const auto name = std::string{description};
+  if (kind == "icosphere") {
+    return Icosphere(level_or(2), name);
+  }
+  if (kind == "grid") {
+    return Grid(level_or(16), level_or(16), name);
+  }
+  if (kind == "torus") {
+    return Torus(level_or(32) * 2, level_or(32), name);
+  }
+  if (kind == "cubesphere") {
+    return CubeSphere(level_or(8), name);
+  }
+  throw std::runtime_error("Unknown generated solid '" + std::string{description} + "', expected icosphere, grid, torus or cubesphere!");
+}
 } // namespace Vis
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "index_buffer.hpp"
 #include "vertex.hpp"
 
 namespace Vis {
@@ -17,18 +20,38 @@ struct Layout {
   size_t count;
 };
 
+class MappedFile;
+
 struct Solid {
   std::string name{""};
   std::vector<Vertex> vertices{};
-  std::vector<size_t> indices{};
+  IndexBuffer indices{};
   std::vector<Layout> layout{};
   glm::dmat4 matrix{1.0};
+  // Set by load_solid, keeps the file alive while its indices or, when the
+  // precision matches, its vertices are used in place. `vertices` stays empty
+  // while mapped_vertices is set. Copies of the solid share the mapping.
+  std::shared_ptr<const MappedFile> mapping{};
+  std::span<const Vertex> mapped_vertices{};
+
+  [[nodiscard]] auto get_vertices() const -> std::span<const Vertex>;
 
   static auto Cube(const std::string_view name = "") -> Solid;
   static auto Axis(const std::string_view name = "") -> Solid;
   static auto Triangle(const std::string_view name = "") -> Solid;
   static auto Square(const std::string_view name = "") -> Solid;
   static auto Icosphere(const std::string_view name = "") -> Solid;
+  // Generated solids for scaling tests, indexed with shared vertices. The
+  // icosphere has 20 * 4^subdivisions triangles, the cube sphere
+  // 12 * subdivisions^2. The grid spans the Square, the torus lies around the x
+  // axis within the [-1, 1] cube.
+  static auto Icosphere(const size_t subdivisions, const std::string_view name = "") -> Solid;
+  static auto Grid(const size_t columns, const size_t rows, const std::string_view name = "") -> Solid;
+  static auto Torus(const size_t rings, const size_t sides, const std::string_view name = "") -> Solid;
+  static auto CubeSphere(const size_t subdivisions, const std::string_view name = "") -> Solid;
+  // Parses `<kind>[:<level>]`: icosphere:<subdivisions>, grid:<cells per side>,
+  // torus:<sides> with twice as many rings, or cubesphere:<cells per face side>.
+  static auto Generate(const std::string_view description) -> Solid;
 };
 
 } // namespace Vis
@@ -0,0 +1,201 @@
+#include "solid_file.hpp"
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Vis {
+
+namespace {
+
+constexpr std::array<char, 8> solid_magic{'V', 'I', 'S', 'S', 'O', 'L', 'I', 'D'};
+constexpr uint32_t solid_version{1};
+constexpr uint64_t block_alignment{64};
+constexpr size_t reals_per_vertex{11};
+
+struct SolidFileHeader {
+  std::array<char, 8> magic{solid_magic};
+  uint32_t version{solid_version};
+  uint32_t real_size{sizeof(Real)};
+  uint64_t name_offset{0};
+  uint64_t name_size{0};
+  uint64_t vertex_offset{0};
+  uint64_t vertex_count{0};
+  uint64_t index_offset{0};
+  uint64_t index_count{0};
+  uint64_t layout_offset{0};
+  uint64_t layout_count{0};
+  std::array<double, 16> matrix{};
+};
+
+struct SolidFileLayout {
+  uint32_t topology{0};
+  uint32_t reserved{0};
+  uint64_t start{0};
+  uint64_t count{0};
+};
+
+static_assert(std::is_trivially_copyable_v<SolidFileHeader> && sizeof(SolidFileHeader) == 208);
+static_assert(sizeof(SolidFileLayout) == 24);
+// Vertices are read in place, so they must be exactly reals_per_vertex reals.
+static_assert(sizeof(Vertex) == reals_per_vertex * sizeof(Real));
+
+auto align(const uint64_t offset) -> uint64_t { return (offset + block_alignment - 1) / block_alignment * block_alignment; }
+
+auto vertices_per_primitive(const Topology topology) -> uint64_t {
+  switch (topology) {
+  case Topology::Point: {
+    return 1;
+  }
+  case Topology::Line: {
+    return 2;
+  }
+  default: {
+    return 3;
+  }
+  }
+}
+
+template <typename T> auto convert_vertices(const char *data, const size_t count, std::vector<Vertex> &vertices) -> void {
+  vertices.resize(count);
+  std::array<T, reals_per_vertex> reals{};
+  for (size_t i = 0; i < count; ++i) {
+    std::memcpy(reals.data(), data + i * sizeof(reals), sizeof(reals));
+    vertices[i] = {{reals[0], reals[1], reals[2], reals[3]}, {reals[4], reals[5], reals[6], reals[7]}, {reals[8], reals[9]}, static_cast<Real>(reals[10])};
+  }
+}
+
+} // namespace
+
+auto save_solid(const Solid &solid, const std::string &path) -> void {
+  static_assert(std::endian::native == std::endian::little, "Solid files are little endian");
+  const auto vertices = solid.get_vertices();
+  if (vertices.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Solid has too many vertices for 32 bit indices!");
+  }
+  SolidFileHeader header{};
+  header.name_offset = align(sizeof(SolidFileHeader));
+  header.name_size = solid.name.size();
+  header.vertex_offset = align(header.name_offset + header.name_size);
+  header.vertex_count = vertices.size();
+  header.index_offset = align(header.vertex_offset + vertices.size_bytes());
+  header.index_count = solid.indices.size();
+  header.layout_offset = align(header.index_offset + header.index_count * sizeof(uint32_t));
+  header.layout_count = solid.layout.size();
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 4; ++row) {
+      header.matrix[static_cast<size_t>(column * 4 + row)] = solid.matrix[column][row];
+    }
+  }
+  std::vector<uint32_t> widened;
+  auto indices = solid.indices.get_format() == IndexFormat::UInt32 ? solid.indices.get_indices<uint32_t>() : std::span<const uint32_t>{};
+  if (solid.indices.get_format() == IndexFormat::UInt16) {
+    const auto narrow = solid.indices.get_indices<uint16_t>();
+    widened.assign(narrow.begin(), narrow.end());
+    indices = widened;
+  }
+  std::vector<SolidFileLayout> layouts;
+  layouts.reserve(solid.layout.size());
+  for (const auto &layout : solid.layout) {
+    layouts.push_back({static_cast<uint32_t>(layout.topology), 0, layout.start, layout.count});
+  }
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot write solid \"" + path + "\"!");
+  }
+  uint64_t offset{0};
+  const auto write = [&](const uint64_t block_offset, const void *data, const uint64_t size) {
+    static constexpr std::array<char, block_alignment> padding{};
+    file.write(padding.data(), static_cast<std::streamsize>(block_offset - offset));
+    file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    offset = block_offset + size;
+  };
+  write(0, &header, sizeof(header));
+  write(header.name_offset, solid.name.data(), header.name_size);
+  write(header.vertex_offset, vertices.data(), vertices.size_bytes());
+  write(header.index_offset, indices.data(), indices.size_bytes());
+  write(header.layout_offset, layouts.data(), layouts.size() * sizeof(SolidFileLayout));
+  if (!file) {
+    throw std::runtime_error("Failed to write solid \"" + path + "\"!");
+  }
+}
+
+auto load_solid(const std::string &path) -> Solid {
+  static_assert(std::endian::native == std::endian::little, "Solid files are little endian");
+  auto file = std::make_shared<const MappedFile>(path);
+  const auto *data = file->get_data();
+  const auto size = file->get_size();
+  const auto fail = [&](const std::string &what) { throw std::runtime_error("Solid \"" + path + "\" " + what + "!"); };
+  SolidFileHeader header{};
+  if (size < sizeof(header)) {
+    fail("is truncated");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic != solid_magic) {
+    fail("is not a solid file");
+  }
+  if (header.version != solid_version) {
+    fail("has unsupported version " + std::to_string(header.version));
+  }
+  if (header.real_size != sizeof(float) && header.real_size != sizeof(double)) {
+    fail("has invalid real size");
+  }
+  const auto check_block = [&](const uint64_t offset, const uint64_t count, const uint64_t element_size) {
+    if (offset % block_alignment != 0 || offset > size || count > (size - offset) / element_size) {
+      fail("is truncated");
+    }
+  };
+  const uint64_t vertex_size = reals_per_vertex * header.real_size;
+  check_block(header.name_offset, header.name_size, 1);
+  check_block(header.vertex_offset, header.vertex_count, vertex_size);
+  check_block(header.index_offset, header.index_count, sizeof(uint32_t));
+  check_block(header.layout_offset, header.layout_count, sizeof(SolidFileLayout));
+
+  Solid solid{};
+  solid.name.assign(data + header.name_offset, header.name_size);
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 4; ++row) {
+      solid.matrix[column][row] = header.matrix[static_cast<size_t>(column * 4 + row)];
+    }
+  }
+  const auto *vertex_data = data + header.vertex_offset;
+  if (header.real_size == sizeof(Real)) {
+    solid.mapped_vertices = {reinterpret_cast<const Vertex *>(vertex_data), header.vertex_count};
+  } else if (header.real_size == sizeof(float)) {
+    convert_vertices<float>(vertex_data, header.vertex_count, solid.vertices);
+  } else {
+    convert_vertices<double>(vertex_data, header.vertex_count, solid.vertices);
+  }
+
+  const std::span<const uint32_t> indices{reinterpret_cast<const uint32_t *>(data + header.index_offset), header.index_count};
+  if (!indices.empty() && *std::max_element(indices.begin(), indices.end()) >= header.vertex_count) {
+    fail("has an index out of range");
+  }
+  solid.indices.set_mapped(indices);
+
+  solid.layout.reserve(header.layout_count);
+  for (size_t i = 0; i < header.layout_count; ++i) {
+    SolidFileLayout layout{};
+    std::memcpy(&layout, data + header.layout_offset + i * sizeof(SolidFileLayout), sizeof(SolidFileLayout));
+    if (layout.topology > static_cast<uint32_t>(Topology::Triangle)) {
+      fail("has an invalid topology");
+    }
+    const auto topology = static_cast<Topology>(layout.topology);
+    if (layout.start > header.index_count || layout.count > (header.index_count - layout.start) / vertices_per_primitive(topology)) {
+      fail("has a layout out of range");
+    }
+    solid.layout.push_back({topology, layout.start, layout.count});
+  }
+  solid.mapping = std::move(file);
+  return solid;
+}
+
+} // namespace Vis
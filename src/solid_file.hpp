@@ -0,0 +1,17 @@
+#pragma once
+
+#include "solid.hpp"
+
+#include <string>
+
+namespace Vis {
+
+// Native binary Solid, little endian. A header with the matrix is followed by
+// 64 byte aligned blocks: the name, the vertices as pos, col, tex and one in
+// reals of the writer's precision, 32 bit indices and the Layout table.
+// load_solid maps the file and uses the indices in place, and the vertices
+// too when their precision matches Real, otherwise they are converted.
+auto save_solid(const Solid &solid, const std::string &path) -> void;
+[[nodiscard]] auto load_solid(const std::string &path) -> Solid;
+
+} // namespace Vis
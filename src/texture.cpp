@@ -1,8 +1,20 @@
 #include "texture.hpp"
 
 namespace Vis {
-Texture::Texture() { glGenTextures(1, &m_id); }
-Texture::~Texture() {}
+Texture::Texture() {
+  glGenTextures(1, &m_id);
+  glBindTexture(GL_TEXTURE_2D, m_id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+Texture::~Texture() { glDeleteTextures(1, &m_id); }
+
+auto Texture::storage(const size_t width, const size_t height) -> void {
+  glBindTexture(GL_TEXTURE_2D, m_id);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+}
 
 auto Texture::bind() -> void { glBindTexture(GL_TEXTURE_2D, m_id); }
 
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include <cstddef>
+
 namespace Vis {
 
 class Texture {
@@ -9,6 +11,8 @@ public:
   Texture();
   ~Texture();
 
+  // Immutable RGBA8 storage, a new size needs a new Texture.
+  auto storage(const size_t width, const size_t height) -> void;
   auto bind() -> void;
   auto unbind() -> void;
   static auto active_texture(int texture_slot) -> void;
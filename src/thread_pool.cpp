@@ -0,0 +1,95 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace Vis {
+
+namespace {
+
+// Set on pool threads, so a parallel_for issued from a job runs inline.
+thread_local bool s_in_worker{false};
+
+} // namespace
+
+ThreadPool::ThreadPool(const size_t thread_count) {
+  // The calling thread takes part in every parallel_for, so it counts as one.
+  for (size_t i = 1; i < std::max<size_t>(thread_count, 1); ++i) {
+    m_threads.emplace_back([this] { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+}
+
+auto ThreadPool::parallel_for(const size_t count, const std::function<void(size_t index)> &job) -> void {
+  if (count == 0) {
+    return;
+  }
+  if (m_threads.empty() || count == 1 || s_in_worker) {
+    for (size_t i = 0; i < count; ++i) {
+      job(i);
+    }
+    return;
+  }
+  std::lock_guard submit_lock(m_submit_mutex);
+  {
+    std::lock_guard lock(m_mutex);
+    p_job = &job;
+    m_count = count;
+    m_next = 0;
+    m_active = m_threads.size();
+    ++m_generation;
+  }
+  m_start.notify_all();
+  drain();
+  std::unique_lock lock(m_mutex);
+  m_done.wait(lock, [this] { return m_active == 0; });
+  p_job = nullptr;
+}
+
+[[nodiscard]] auto ThreadPool::get_thread_count() const -> size_t {
+  return m_threads.size() + 1;
+}
+
+[[nodiscard]] auto ThreadPool::instance() -> ThreadPool & {
+  static ThreadPool s_pool;
+  return s_pool;
+}
+
+auto ThreadPool::worker_loop() -> void {
+  s_in_worker = true;
+  uint64_t generation{0};
+  while (true) {
+    {
+      std::unique_lock lock(m_mutex);
+      m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+      if (m_stop) {
+        return;
+      }
+      generation = m_generation;
+    }
+    drain();
+    {
+      std::lock_guard lock(m_mutex);
+      if (--m_active == 0) {
+        m_done.notify_one();
+      }
+    }
+  }
+}
+
+auto ThreadPool::drain() -> void {
+  for (size_t i = m_next.fetch_add(1); i < m_count; i = m_next.fetch_add(1)) {
+    (*p_job)(i);
+  }
+}
+
+} // namespace Vis
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Vis {
+
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+
+  auto parallel_for(size_t count, const std::function<void(size_t index)> &job) -> void;
+
+  [[nodiscard]] auto get_thread_count() const -> size_t;
+  [[nodiscard]] static auto instance() -> ThreadPool &;
+
+private:
+  auto worker_loop() -> void;
+  auto drain() -> void;
+
+private:
+  std::vector<std::thread> m_threads{};
+  std::mutex m_submit_mutex{};
+  std::mutex m_mutex{};
+  std::condition_variable m_start{};
+  std::condition_variable m_done{};
+  const std::function<void(size_t)> *p_job{nullptr};
+  size_t m_count{0};
+  std::atomic<size_t> m_next{0};
+  size_t m_active{0};
+  uint64_t m_generation{0};
+  bool m_stop{false};
+};
+
+} // namespace Vis
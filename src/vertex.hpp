@@ -1,33 +1,48 @@
 #pragma once
 #include <glm/glm.hpp>
 namespace Vis {
+// VIS_FLOAT_PRECISION switches the vertex stream, the interpolated attributes
+// and the depth buffer to single precision.
+#if defined(VIS_FLOAT_PRECISION)
+using Real = float;
+using Vec2 = glm::vec2;
+using Vec3 = glm::vec3;
+using Vec4 = glm::vec4;
+using Mat4 = glm::mat4;
+#else
+using Real = double;
+using Vec2 = glm::dvec2;
+using Vec3 = glm::dvec3;
+using Vec4 = glm::dvec4;
+using Mat4 = glm::dmat4;
+#endif
 struct Vertex {
-  glm::dvec4 pos;
-  glm::dvec4 col{1.0f, 1.0f, 1.0f, 1.0f};
-  glm::dvec2 tex{0.0f, 0.0f};
-  double one{1.0};
+  Vec4 pos;
+  Vec4 col{1.0f, 1.0f, 1.0f, 1.0f};
+  Vec2 tex{0.0f, 0.0f};
+  Real one{1.0};
   constexpr inline Vertex operator+(const Vertex &vertex) const {
     return {pos + vertex.pos, col + vertex.col, tex + vertex.tex,
             one + vertex.one};
   }
-  constexpr inline Vertex operator+(const double f) const {
+  constexpr inline Vertex operator+(const Real f) const {
     return {pos + f, col + f, tex + f, one + f};
   }
   constexpr inline Vertex operator-(const Vertex &vertex) const {
     return {pos - vertex.pos, col - vertex.col, tex - vertex.tex,
             one - vertex.one};
   }
-  constexpr inline Vertex operator-(const double f) const {
+  constexpr inline Vertex operator-(const Real f) const {
     return {pos - f, col - f, tex - f, one - f};
   }
   constexpr inline Vertex operator*(const Vertex &vertex) const {
     return {pos * vertex.pos, col * vertex.col, tex * vertex.tex,
             one * vertex.one};
   }
-  constexpr inline Vertex operator*(const double f) const {
+  constexpr inline Vertex operator*(const Real f) const {
     return {pos * f, col * f, tex * f, one * f};
   }
-  constexpr inline static Vertex interpolate(const double t, const Vertex &a,
+  constexpr inline static Vertex interpolate(const Real t, const Vertex &a,
                                              const Vertex &b) {
     if (t <= 0.0) {
       return a;
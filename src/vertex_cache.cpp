@@ -0,0 +1,96 @@
+#include "vertex_cache.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Vis {
+
+template <typename Index>
+auto VertexCache::fetch(std::span<const Vertex> vertices,
+                        std::span<const Index> indices,
+                        const glm::dmat4 &matrix,
+                        std::vector<Vertex> &out) -> void {
+  out.clear();
+  out.reserve(indices.size());
+  m_fetched_count += indices.size();
+  // Index ranges that touch only a small part of a big vertex buffer are
+  // streamed through the FIFO instead of a buffer sized to every vertex.
+  if (vertices.size() <= indices.size()) {
+    fetch_full(vertices, indices, matrix, out);
+  } else {
+    fetch_fifo(vertices, indices, matrix, out);
+  }
+}
+
+[[nodiscard]] auto VertexCache::get_transformed_count() const -> size_t {
+  return m_transformed_count;
+}
+
+[[nodiscard]] auto VertexCache::get_fetched_count() const -> size_t {
+  return m_fetched_count;
+}
+
+template <typename Index>
+auto VertexCache::fetch_full(std::span<const Vertex> vertices,
+                             std::span<const Index> indices,
+                             const glm::dmat4 &matrix,
+                             std::vector<Vertex> &out) -> void {
+  if (m_transformed.size() < vertices.size()) {
+    m_transformed.resize(vertices.size());
+    m_stamps.resize(vertices.size(), 0);
+  }
+  if (m_stamp == std::numeric_limits<uint32_t>::max()) {
+    std::fill(m_stamps.begin(), m_stamps.end(), 0);
+    m_stamp = 0;
+  }
+  ++m_stamp;
+  const Mat4 transform{matrix};
+  for (const auto index : indices) {
+    if (m_stamps[index] != m_stamp) {
+      m_stamps[index] = m_stamp;
+      m_transformed[index] = vertices[index];
+      m_transformed[index].pos = transform * vertices[index].pos;
+      ++m_transformed_count;
+    }
+    out.push_back(m_transformed[index]);
+  }
+}
+
+template <typename Index>
+auto VertexCache::fetch_fifo(std::span<const Vertex> vertices,
+                             std::span<const Index> indices,
+                             const glm::dmat4 &matrix,
+                             std::vector<Vertex> &out) -> void {
+  m_fifo_indices.fill(std::numeric_limits<size_t>::max());
+  m_fifo_next = 0;
+  const Mat4 transform{matrix};
+  for (const auto index : indices) {
+    const auto hit = std::find(m_fifo_indices.begin(), m_fifo_indices.end(), index);
+    if (hit != m_fifo_indices.end()) {
+      out.push_back(m_fifo_vertices[static_cast<size_t>(hit - m_fifo_indices.begin())]);
+      continue;
+    }
+    auto &vertex = m_fifo_vertices[m_fifo_next];
+    vertex = vertices[index];
+    vertex.pos = transform * vertex.pos;
+    m_fifo_indices[m_fifo_next] = index;
+    m_fifo_next = (m_fifo_next + 1) % fifo_size;
+    ++m_transformed_count;
+    out.push_back(vertex);
+  }
+}
+
+template auto VertexCache::fetch<uint16_t>(std::span<const Vertex> vertices,
+                                          std::span<const uint16_t> indices,
+                                          const glm::dmat4 &matrix,
+                                          std::vector<Vertex> &out) -> void;
+template auto VertexCache::fetch<uint32_t>(std::span<const Vertex> vertices,
+                                          std::span<const uint32_t> indices,
+                                          const glm::dmat4 &matrix,
+                                          std::vector<Vertex> &out) -> void;
+template auto VertexCache::fetch<size_t>(std::span<const Vertex> vertices,
+                                        std::span<const size_t> indices,
+                                        const glm::dmat4 &matrix,
+                                        std::vector<Vertex> &out) -> void;
+
+} // namespace Vis
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vertex.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Vis {
+
+class VertexCache {
+public:
+  static constexpr size_t fifo_size{32};
+
+  VertexCache() = default;
+  ~VertexCache() = default;
+
+  // Instantiated for 16, 32 and 64 bit indices.
+  template <typename Index>
+  auto fetch(std::span<const Vertex> vertices, std::span<const Index> indices,
+             const glm::dmat4 &matrix, std::vector<Vertex> &out) -> void;
+
+  [[nodiscard]] auto get_transformed_count() const -> size_t;
+  [[nodiscard]] auto get_fetched_count() const -> size_t;
+
+private:
+  template <typename Index>
+  auto fetch_full(std::span<const Vertex> vertices,
+                  std::span<const Index> indices, const glm::dmat4 &matrix,
+                  std::vector<Vertex> &out) -> void;
+  template <typename Index>
+  auto fetch_fifo(std::span<const Vertex> vertices,
+                  std::span<const Index> indices, const glm::dmat4 &matrix,
+                  std::vector<Vertex> &out) -> void;
+
+private:
+  std::vector<Vertex> m_transformed{};
+  std::vector<uint32_t> m_stamps{};
+  uint32_t m_stamp{0};
+  std::array<size_t, fifo_size> m_fifo_indices{};
+  std::array<Vertex, fifo_size> m_fifo_vertices{};
+  size_t m_fifo_next{0};
+  size_t m_transformed_count{0};
+  size_t m_fetched_count{0};
+};
+
+} // namespace Vis
@@ -0,0 +1,67 @@
+#include "vertex_stream.hpp"
+
+namespace Vis {
+
+[[nodiscard]] auto VertexStream::size() const -> size_t { return x.size(); }
+
+auto VertexStream::resize(const size_t size) -> void {
+  for (auto *component : {&x, &y, &z, &w}) {
+    component->resize(size);
+  }
+}
+
+auto VertexStream::load(std::span<const Vertex> vertices) -> void {
+  resize(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const auto &vertex = vertices[i];
+    x[i] = vertex.pos.x;
+    y[i] = vertex.pos.y;
+    z[i] = vertex.pos.z;
+    w[i] = vertex.pos.w;
+  }
+}
+
+[[nodiscard]] auto VertexStream::get_position(const size_t index) const -> Vec4 { return {x[index], y[index], z[index], w[index]}; }
+
+namespace Alg {
+
+auto classify_stream(const VertexStream &stream, std::vector<uint8_t> &outcodes) -> void {
+  const auto size = stream.size();
+  outcodes.resize(size);
+  const auto *p_x = stream.x.data();
+  const auto *p_y = stream.y.data();
+  const auto *p_z = stream.z.data();
+  const auto *p_w = stream.w.data();
+  auto *p_outcodes = outcodes.data();
+  for (size_t i = 0; i < size; ++i) {
+    const auto x = p_x[i];
+    const auto y = p_y[i];
+    const auto z = p_z[i];
+    const auto w = p_w[i];
+    p_outcodes[i] = static_cast<uint8_t>((x < -w ? Outcode::left : 0) | (x > w ? Outcode::right : 0) | (y < -w ? Outcode::bottom : 0) | (y > w ? Outcode::top : 0) | (z < 0 ? Outcode::z_near : 0) | (z > w ? Outcode::z_far : 0));
+  }
+}
+
+auto trasform_stream_by_matrix(VertexStream &stream, const glm::dmat4 &matrix) -> void {
+  const Mat4 m{matrix};
+  const auto size = stream.size();
+  auto *p_x = stream.x.data();
+  auto *p_y = stream.y.data();
+  auto *p_z = stream.z.data();
+  auto *p_w = stream.w.data();
+  for (size_t i = 0; i < size; ++i) {
+    const auto x = p_x[i];
+    const auto y = p_y[i];
+    const auto z = p_z[i];
+    const auto w = p_w[i];
+    // Same association as glm's mat4 * vec4, so results match the AoS path.
+    p_x[i] = (m[0][0] * x + m[1][0] * y) + (m[2][0] * z + m[3][0] * w);
+    p_y[i] = (m[0][1] * x + m[1][1] * y) + (m[2][1] * z + m[3][1] * w);
+    p_z[i] = (m[0][2] * x + m[1][2] * y) + (m[2][2] * z + m[3][2] * w);
+    p_w[i] = (m[0][3] * x + m[1][3] * y) + (m[2][3] * z + m[3][3] * w);
+  }
+}
+
+} // namespace Alg
+
+} // namespace Vis
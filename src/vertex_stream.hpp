@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vertex.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Vis {
+
+// Frustum planes a clip space position lies outside of, as tested by the
+// clip_fast_* stages.
+struct Outcode {
+  static constexpr uint8_t left{1 << 0};
+  static constexpr uint8_t right{1 << 1};
+  static constexpr uint8_t bottom{1 << 2};
+  static constexpr uint8_t top{1 << 3};
+  static constexpr uint8_t z_near{1 << 4};
+  static constexpr uint8_t z_far{1 << 5};
+};
+
+// Structure of arrays copy of the positions of a vertex range, so the
+// transform and frustum kernels only stream the components they work on.
+// Attributes stay in the source vertices and are gathered from there.
+struct VertexStream {
+  std::vector<Real> x{};
+  std::vector<Real> y{};
+  std::vector<Real> z{};
+  std::vector<Real> w{};
+
+  [[nodiscard]] auto size() const -> size_t;
+  auto resize(const size_t size) -> void;
+  auto load(std::span<const Vertex> vertices) -> void;
+  [[nodiscard]] auto get_position(const size_t index) const -> Vec4;
+};
+
+namespace Alg {
+auto classify_stream(const VertexStream &stream, std::vector<uint8_t> &outcodes) -> void;
+auto trasform_stream_by_matrix(VertexStream &stream, const glm::dmat4 &matrix) -> void;
+} // namespace Alg
+
+} // namespace Vis